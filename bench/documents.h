@@ -0,0 +1,231 @@
+// Generated documents shared by the benchmarks.
+
+#ifndef BENCH_DOCUMENTS_H_
+#define BENCH_DOCUMENTS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  char *text;
+  size_t length;
+  size_t capacity;
+} Buffer;
+
+static void append(Buffer *b, const char *text) {
+  size_t length = strlen(text);
+  if (b->length + length + 1 > b->capacity) {
+    b->capacity = (b->length + length + 1) * 2;
+    b->text = realloc(b->text, b->capacity);
+  }
+  memcpy(b->text + b->length, text, length + 1);
+  b->length += length;
+}
+
+static void append_indent(Buffer *b, int indent) {
+  for (int i = 0; i < indent; ++i) {
+    append(b, " ");
+  }
+}
+
+static const char *words[] = {
+    "lorem", "ipsum",   "dolor", "sit",        "amet",   "consectetur",
+    "elit",  "sed",     "do",    "eiusmod",    "tempor", "incididunt",
+    "ut",    "labore",  "et",    "dolore",     "magna",  "aliqua",
+    "enim",  "minim",   "quis",  "exercitation",
+};
+
+static void append_prose_line(Buffer *b, unsigned *seed, int word_count) {
+  for (int i = 0; i < word_count; ++i) {
+    *seed = *seed * 1103515245 + 12345;
+    if (i > 0) {
+      append(b, " ");
+    }
+    append(b, words[(*seed >> 16) % (sizeof(words) / sizeof(words[0]))]);
+  }
+  append(b, "\n");
+}
+
+// Paragraphs of plain text.
+static void generate_prose(Buffer *b) {
+  unsigned seed = 1;
+  for (int p = 0; p < 200; ++p) {
+    for (int line = 0; line < 4; ++line) {
+      append_prose_line(b, &seed, 12);
+    }
+    append(b, "\n");
+  }
+}
+
+// A single paragraph of `lines` lines of words, each at least
+// `line_length` bytes long.
+static void generate_long_lines(Buffer *b, int lines, int line_length) {
+  unsigned seed = 1;
+  for (int line = 0; line < lines; ++line) {
+    size_t start = b->length;
+    while (b->length - start < (size_t)line_length) {
+      seed = seed * 1103515245 + 12345;
+      if (b->length > start) {
+        append(b, " ");
+      }
+      append(b, words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))]);
+    }
+    append(b, "\n");
+  }
+}
+
+// Block quotes containing divs containing lists, nested `depth` times.
+static void generate_nested(Buffer *b, int depth) {
+  unsigned seed = 2;
+  for (int repeat = 0; repeat < 20; ++repeat) {
+    Buffer prefix = {0};
+    append(&prefix, "");
+    int indent = 0;
+    for (int d = 0; d < depth; ++d) {
+      switch (d % 3) {
+      case 0:
+        append(&prefix, "> ");
+        append(b, prefix.text);
+        append(b, "\n");
+        break;
+      case 1:
+        append(b, prefix.text);
+        append_indent(b, indent);
+        append(b, d % 2 ? "::::\n" : ":::\n");
+        break;
+      case 2:
+        append(b, prefix.text);
+        append_indent(b, indent);
+        append(b, "- ");
+        append_prose_line(b, &seed, 6);
+        append(b, prefix.text);
+        append(b, "\n");
+        indent += 2;
+        break;
+      }
+    }
+    append(b, prefix.text);
+    append_indent(b, indent);
+    append_prose_line(b, &seed, 8);
+    append(b, "\n");
+    free(prefix.text);
+  }
+}
+
+// Top level lists of every marker type.
+static void generate_lists(Buffer *b) {
+  static const char *markers[] = {"- ",   "* ",     "+ ",  "1. ", "a) ",
+                                  "(i) ", "- [x] ", "B. ", ": "};
+  unsigned seed = 3;
+  for (int list = 0; list < 60; ++list) {
+    const char *marker = markers[list % (sizeof(markers) / sizeof(*markers))];
+    for (int item = 0; item < 8; ++item) {
+      append(b, marker);
+      append_prose_line(b, &seed, 8);
+      append(b, "\n");
+    }
+    append(b, "Between lists\n\n");
+  }
+}
+
+// Lines starting with markers, or with text that looks like one: tight lists
+// of changing types, paragraphs interrupted by lists and block quotes with
+// lazy continuation lines.
+static void generate_line_starts(Buffer *b) {
+  static const char *markers[] = {"- ", "1. ", "* ", "a) ", "+ ", "(ii) "};
+  static const char *lookalikes[] = {"-dash ", "1a ", "ii ", "(i ", "B.C. "};
+  unsigned seed = 5;
+  for (int section = 0; section < 100; ++section) {
+    for (int item = 0; item < 6; ++item) {
+      append(b, markers[(section + item / 2) % 6]);
+      append_prose_line(b, &seed, 5);
+    }
+    append(b, "\n");
+
+    for (int line = 0; line < 4; ++line) {
+      append(b, lookalikes[(section + line) % 5]);
+      append_prose_line(b, &seed, 6);
+    }
+    append(b, "- ");
+    append_prose_line(b, &seed, 6);
+    append(b, "\n");
+
+    append(b, "> ");
+    append_prose_line(b, &seed, 6);
+    append_prose_line(b, &seed, 6);
+    append(b, "> > ");
+    append_prose_line(b, &seed, 6);
+    append(b, "\n");
+  }
+}
+
+// A data export: a pipe table of `rows` rows of words and numbers, with a
+// bit of markup in every tenth row.
+static void generate_table(Buffer *b, int rows) {
+  unsigned seed = 6;
+  append(b, "| id | name | amount | note |\n|---:|------|-------:|------|\n");
+  char number[32];
+  for (int row = 0; row < rows; ++row) {
+    seed = seed * 1103515245 + 12345;
+    snprintf(number, sizeof(number), "| %d | ", row);
+    append(b, number);
+    append(b, words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))]);
+    snprintf(number, sizeof(number), " | %u.%02u | ", (seed >> 8) % 10000,
+             seed % 100);
+    append(b, number);
+    append(b, row % 10 ? "ok" : "_see_ `notes`");
+    append(b, " |\n");
+  }
+}
+
+// A pipe table of `rows` rows of `columns` words each, without markup.
+static void generate_wide_table(Buffer *b, int rows, int columns) {
+  unsigned seed = 7;
+  for (int row = 0; row < rows; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      seed = seed * 1103515245 + 12345;
+      append(b, "| ");
+      append(b, words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))]);
+      append(b, " ");
+    }
+    append(b, "|\n");
+  }
+}
+
+// A document with a bit of everything, split into sections.
+static void generate_mixed(Buffer *b, int sections) {
+  unsigned seed = 4;
+  for (int section = 0; section < sections; ++section) {
+    append(b, section % 3 ? "## Section\n\n" : "# Chapter\n\n");
+
+    for (int p = 0; p < 3; ++p) {
+      append_prose_line(b, &seed, 10);
+      append(b, "with _emphasis_, *strong*, `verbatim` and [a link](url)\n");
+      append_prose_line(b, &seed, 10);
+      append(b, "\n");
+    }
+
+    append(b, "- ");
+    append_prose_line(b, &seed, 6);
+    append(b, "\n  1. ");
+    append_prose_line(b, &seed, 6);
+    append(b, "  2. ");
+    append_prose_line(b, &seed, 6);
+    append(b, "\n- ");
+    append_prose_line(b, &seed, 6);
+    append(b, "\n");
+
+    append(b, "> ");
+    append_prose_line(b, &seed, 8);
+    append(b, "> ");
+    append_prose_line(b, &seed, 8);
+    append(b, "\n");
+
+    append(b, "```c\nint main(void) {\n  return 0;\n}\n```\n\n");
+
+    append(b, "| a | b |\n|---|--:|\n| 1 | 2 |\n\n");
+  }
+}
+
+#endif // BENCH_DOCUMENTS_H_
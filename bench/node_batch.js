@@ -0,0 +1,70 @@
+// Throughput of `parseBatch`, which parses on the libuv thread pool, against
+// parsing the same documents one at a time with `Parser.parse`.
+//
+//   npm run bench -- [FILE...]
+//
+// Without files it parses the benchmark fixtures (`make fixtures`). The
+// thread pool has UV_THREADPOOL_SIZE threads, 4 unless set.
+
+const fs = require("fs");
+const path = require("path");
+const Parser = require("tree-sitter");
+const Djot = require("..");
+
+const fixtures = path.join(__dirname, "fixtures");
+
+// Each file is parsed COPIES times, so there are enough documents to spread
+// over the thread pool.
+const copies = Number(process.env.COPIES) || 20;
+
+function documents() {
+  let files = process.argv.slice(2);
+  if (files.length === 0) {
+    files = fs
+      .readdirSync(fixtures)
+      .filter((file) => file.endsWith(".dj"))
+      .map((file) => path.join(fixtures, file));
+  }
+  const texts = files.map((file) => fs.readFileSync(file));
+  return Array.from({ length: copies }, () => texts).flat();
+}
+
+function report(name, docs, bytes, ms) {
+  const mbs = bytes / (ms / 1e3) / 1e6;
+  const rate = docs / (ms / 1e3);
+  console.log(
+    `${name.padEnd(20)} ${ms.toFixed(1).padStart(10)} ` +
+      `${rate.toFixed(0).padStart(10)} ${mbs.toFixed(2).padStart(8)}`,
+  );
+}
+
+async function main() {
+  const docs = documents();
+  const bytes = docs.reduce((sum, doc) => sum + doc.length, 0);
+  console.log(`${docs.length} documents, ${bytes} bytes\n`);
+  console.log(
+    `${"".padEnd(20)} ${"ms".padStart(10)} ${"docs/s".padStart(10)} ` +
+      `${"MB/s".padStart(8)}`,
+  );
+
+  const parser = new Parser();
+  parser.setLanguage(Djot);
+  let start = performance.now();
+  for (const doc of docs) {
+    parser.parse(doc.toString());
+  }
+  report("Parser.parse", docs.length, bytes, performance.now() - start);
+
+  const poolSize = Number(process.env.UV_THREADPOOL_SIZE) || 4;
+  for (let threads = 1; threads <= poolSize; threads *= 2) {
+    start = performance.now();
+    const results = await Djot.parseBatch(docs, { threads });
+    const ms = performance.now() - start;
+    if (results.length !== docs.length) {
+      throw new Error("parseBatch lost documents");
+    }
+    report(`parseBatch x${threads}`, docs.length, bytes, ms);
+  }
+}
+
+main();
@@ -0,0 +1,591 @@
+// Benchmarks for the complete parser, linked against the tree-sitter library.
+//
+// Build and run with `make bench-parse`, which finds the tree-sitter
+// headers and library with pkg-config. `make bench-forks` profiles how often
+// the GLR parser splits its stack instead, on the generated documents and
+// the files in `BENCH_FILES`, and `make bench-release` compares the parse
+// throughput of the default and the optimized `make release` build. The
+// consumer walk compares finding children with `ts_node_child_by_field_id`
+// to scanning the children for a node type, and documents with Windows line
+// endings are parsed as is and through `tree-sitter-djot-crlf.h`.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <tree_sitter/api.h>
+
+#include "documents.h"
+#include "tree-sitter-djot-crlf.h"
+
+const TSLanguage *tree_sitter_djot(void);
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// A set of node ids, used to find the nodes reused from a previous tree.
+typedef struct {
+  const void **ids;
+  size_t capacity;
+} NodeSet;
+
+static size_t node_set_slot(const NodeSet *set, const void *id) {
+  size_t slot = ((uintptr_t)id >> 3) * 11400714819323198485ull;
+  slot &= set->capacity - 1;
+  while (set->ids[slot] && set->ids[slot] != id) {
+    slot = (slot + 1) & (set->capacity - 1);
+  }
+  return slot;
+}
+
+static void node_set_init(NodeSet *set, size_t count) {
+  set->capacity = 1;
+  while (set->capacity < count * 2) {
+    set->capacity <<= 1;
+  }
+  set->ids = calloc(set->capacity, sizeof(*set->ids));
+}
+
+static bool node_set_contains(const NodeSet *set, const void *id) {
+  return set->ids[node_set_slot(set, id)] == id;
+}
+
+static void node_set_insert(NodeSet *set, const void *id) {
+  set->ids[node_set_slot(set, id)] = id;
+}
+
+static size_t count_nodes(TSTree *tree, NodeSet *insert_into,
+                          const NodeSet *reused_from, size_t *reused) {
+  size_t count = 0;
+  TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+  for (;;) {
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    ++count;
+    if (insert_into) {
+      node_set_insert(insert_into, node.id);
+    }
+    if (reused_from && node_set_contains(reused_from, node.id)) {
+      ++*reused;
+    }
+
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      continue;
+    }
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) {
+        ts_tree_cursor_delete(&cursor);
+        return count;
+      }
+    }
+  }
+}
+
+static TSPoint point_at(const char *text, size_t byte) {
+  TSPoint point = {0, 0};
+  for (size_t i = 0; i < byte; ++i) {
+    if (text[i] == '\n') {
+      ++point.row;
+      point.column = 0;
+    } else {
+      ++point.column;
+    }
+  }
+  return point;
+}
+
+// Type a character inside a word somewhere in the document and remove it
+// again, reparsing after each edit.
+static void bench_incremental(const char *name, Buffer *document, int edits) {
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_djot());
+
+  double start = now();
+  TSTree *tree =
+      ts_parser_parse_string(parser, NULL, document->text, document->length);
+  double initial = now() - start;
+  size_t nodes = count_nodes(tree, NULL, NULL, NULL);
+
+  char *text = malloc(document->length + 2);
+  memcpy(text, document->text, document->length + 1);
+  size_t length = document->length;
+
+  unsigned seed = 5;
+  double reparse = 0, worst = 0, reused_ratio = 0;
+  size_t byte = 0;
+  for (int i = 0; i < edits; ++i) {
+    if (i % 2 == 0) {
+      do {
+        seed = seed * 1103515245 + 12345;
+        byte = (seed >> 8) % length;
+      } while (!isalpha((unsigned char)text[byte]));
+
+      memmove(text + byte + 1, text + byte, length - byte + 1);
+      text[byte] = 'x';
+      ++length;
+      TSPoint point = point_at(text, byte);
+      ts_tree_edit(tree, &(TSInputEdit){
+                             .start_byte = byte,
+                             .old_end_byte = byte,
+                             .new_end_byte = byte + 1,
+                             .start_point = point,
+                             .old_end_point = point,
+                             .new_end_point = {point.row, point.column + 1},
+                         });
+    } else {
+      // Remove the character inserted by the previous edit.
+      memmove(text + byte, text + byte + 1, length - byte);
+      --length;
+      TSPoint point = point_at(text, byte);
+      ts_tree_edit(tree, &(TSInputEdit){
+                             .start_byte = byte,
+                             .old_end_byte = byte + 1,
+                             .new_end_byte = byte,
+                             .start_point = point,
+                             .old_end_point = {point.row, point.column + 1},
+                             .new_end_point = point,
+                         });
+    }
+
+    NodeSet previous;
+    node_set_init(&previous, nodes);
+    count_nodes(tree, &previous, NULL, NULL);
+
+    start = now();
+    TSTree *new_tree = ts_parser_parse_string(parser, tree, text, length);
+    double elapsed = now() - start;
+    reparse += elapsed;
+    if (elapsed > worst) {
+      worst = elapsed;
+    }
+
+    size_t reused = 0;
+    nodes = count_nodes(new_tree, NULL, &previous, &reused);
+    reused_ratio += (double)reused / nodes;
+
+    free(previous.ids);
+    ts_tree_delete(tree);
+    tree = new_tree;
+  }
+
+  printf("%-14s %9zu %9zu %10.2f %10.3f %10.3f %8.2f%%\n", name,
+         document->length, nodes, initial * 1e3, reparse * 1e3 / edits,
+         worst * 1e3, reused_ratio * 100 / edits);
+
+  free(text);
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+}
+
+// Counts the stack versions from the parser log. Every step of the parser
+// logs `process version:N, version_count:M` for each of its versions.
+typedef struct {
+  size_t steps;
+  size_t forked_steps;
+  size_t splits;
+  unsigned version_count;
+  unsigned max_versions;
+} ForkProfile;
+
+static void log_versions(void *payload, TSLogType type, const char *message) {
+  ForkProfile *profile = payload;
+  unsigned version, version_count;
+  if (type != TSLogTypeParse ||
+      sscanf(message, "process version:%u, version_count:%u", &version,
+             &version_count) != 2 ||
+      version != 0) {
+    return;
+  }
+
+  ++profile->steps;
+  if (version_count > 1) {
+    ++profile->forked_steps;
+  }
+  if (version_count > profile->version_count) {
+    profile->splits += version_count - profile->version_count;
+  }
+  if (version_count > profile->max_versions) {
+    profile->max_versions = version_count;
+  }
+  profile->version_count = version_count;
+}
+
+static void profile_forks(const char *name, const char *text, size_t length) {
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_djot());
+  ForkProfile profile = {0, 0, 0, 1, 1};
+  ts_parser_set_logger(parser, (TSLogger){&profile, log_versions});
+
+  TSTree *tree = ts_parser_parse_string(parser, NULL, text, length);
+
+  printf("%-24s %9zu %9zu %8.2f%% %9zu %9.2f %6u\n", name, length,
+         profile.steps, profile.forked_steps * 100.0 / profile.steps,
+         profile.splits, profile.splits * 1024.0 / length,
+         profile.max_versions);
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+}
+
+static void profile_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    perror(path);
+    return;
+  }
+  Buffer buffer = {0};
+  char chunk[4096];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk) - 1, file)) > 0) {
+    chunk[read] = '\0';
+    append(&buffer, chunk);
+  }
+  fclose(file);
+
+  const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+  profile_forks(name, buffer.text ? buffer.text : "", buffer.length);
+  free(buffer.text);
+}
+
+static void bench_forks(int file_count, char **files) {
+  Buffer mixed = {0}, prose = {0}, nested = {0}, lists = {0};
+  generate_mixed(&mixed, 1000);
+  generate_prose(&prose);
+  generate_nested(&nested, 16);
+  generate_lists(&lists);
+
+  printf("GLR stack versions\n");
+  printf("%-24s %9s %9s %9s %9s %9s %6s\n", "document", "bytes", "steps",
+         "forked", "splits", "splits/KB", "max");
+  profile_forks("mixed", mixed.text, mixed.length);
+  profile_forks("prose", prose.text, prose.length);
+  profile_forks("nested-16", nested.text, nested.length);
+  profile_forks("lists", lists.text, lists.length);
+  for (int i = 0; i < file_count; ++i) {
+    profile_file(files[i]);
+  }
+
+  free(mixed.text);
+  free(prose.text);
+  free(nested.text);
+  free(lists.text);
+}
+
+// Counts the tokens and the characters the external scanner advances over,
+// from the parser and lexer logs. The lexer logs every character it consumes
+// or skips, and the parser logs the start of every external and internal
+// lex.
+typedef struct {
+  size_t tokens;
+  size_t external_advances;
+  bool in_external_scan;
+} TokenProfile;
+
+static void log_tokens(void *payload, TSLogType type, const char *message) {
+  TokenProfile *profile = payload;
+  if (type == TSLogTypeLex) {
+    if (profile->in_external_scan) {
+      ++profile->external_advances;
+    }
+  } else if (strncmp(message, "lex_external", 12) == 0) {
+    profile->in_external_scan = true;
+  } else if (strncmp(message, "lex_internal", 12) == 0) {
+    profile->in_external_scan = false;
+  } else if (strncmp(message, "lexed_lookahead", 15) == 0) {
+    profile->in_external_scan = false;
+    ++profile->tokens;
+  }
+}
+
+// Parse a document from scratch. The tokens and the external scanner's
+// lookahead are counted from the log of a separate parse, as the cursor only
+// sees visible nodes.
+static void bench_parse(const char *name, Buffer *document, int runs) {
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_djot());
+
+  TokenProfile profile = {0, 0, false};
+  ts_parser_set_logger(parser, (TSLogger){&profile, log_tokens});
+  ts_tree_delete(
+      ts_parser_parse_string(parser, NULL, document->text, document->length));
+  ts_parser_set_logger(parser, (TSLogger){NULL, NULL});
+
+  double best = 0;
+  size_t nodes = 0;
+  for (int r = 0; r < runs; ++r) {
+    double start = now();
+    TSTree *tree =
+        ts_parser_parse_string(parser, NULL, document->text, document->length);
+    double elapsed = now() - start;
+    if (r == 0 || elapsed < best) {
+      best = elapsed;
+    }
+    if (r == 0) {
+      nodes = count_nodes(tree, NULL, NULL, NULL);
+    }
+    ts_tree_delete(tree);
+  }
+
+  printf("%-14s %9zu %9zu %9zu %10.2f %10.2f %9.2f\n", name,
+         document->length, nodes, profile.tokens, best * 1e3,
+         document->length / best / 1e6,
+         (double)profile.external_advances / document->length);
+
+  ts_parser_delete(parser);
+}
+
+static void to_crlf(Buffer *crlf, const Buffer *document) {
+  crlf->capacity = document->length * 2 + 1;
+  crlf->text = malloc(crlf->capacity);
+  crlf->length = 0;
+  for (size_t i = 0; i < document->length; ++i) {
+    if (document->text[i] == '\n') {
+      crlf->text[crlf->length++] = '\r';
+    }
+    crlf->text[crlf->length++] = document->text[i];
+  }
+  crlf->text[crlf->length] = '\0';
+}
+
+static double best_parse(TSParser *parser, const Buffer *document,
+                         DjotCrlfInput *input, int runs, size_t *nodes) {
+  double best = 0;
+  for (int r = 0; r < runs; ++r) {
+    double start = now();
+    TSTree *tree =
+        input ? ts_parser_parse(parser, NULL, djot_crlf_input(input))
+              : ts_parser_parse_string(parser, NULL, document->text,
+                                       document->length);
+    double elapsed = now() - start;
+    if (r == 0 || elapsed < best) {
+      best = elapsed;
+    }
+    if (r == 0) {
+      *nodes = count_nodes(tree, NULL, NULL, NULL);
+    }
+    ts_tree_delete(tree);
+  }
+  return best;
+}
+
+// Parse a document with Windows line endings as is, where the `\r`s are
+// extras, and through the normalizing input, against the LF original.
+static void bench_crlf(const char *name, Buffer *document, int runs) {
+  Buffer crlf = {0};
+  to_crlf(&crlf, document);
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_djot());
+
+  size_t nodes[3];
+  double lf = best_parse(parser, document, NULL, runs, &nodes[0]);
+  double raw = best_parse(parser, &crlf, NULL, runs, &nodes[1]);
+  DjotCrlfInput *input = djot_crlf_input_new(crlf.text, crlf.length);
+  if (!input) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  double adapted = best_parse(parser, &crlf, input, runs, &nodes[2]);
+  djot_crlf_input_delete(input);
+
+  printf("%-14s %9zu %10.2f %10.2f %10.2f %9zu %9zu\n", name, crlf.length,
+         lf * 1e3, raw * 1e3, adapted * 1e3, nodes[1], nodes[2]);
+
+  ts_parser_delete(parser);
+  free(crlf.text);
+}
+
+// A lookup a consumer does on every node of a type: the child a renderer or
+// indexer wants, by field name and by the node type it had to scan for
+// before the grammar had fields.
+typedef struct {
+  const char *parent;
+  const char *field;
+  const char *child;
+} Lookup;
+
+typedef struct {
+  TSSymbol parent;
+  TSFieldId field;
+  TSSymbol child;
+} LookupIds;
+
+static Lookup lookups[] = {
+    {"section", "heading", "heading"},
+    {"heading", "content", "content"},
+    {"code_block", "language", "language"},
+    {"inline_link", "destination", "inline_link_destination"},
+    {"link_reference_definition", "destination", "link_destination"},
+    {"footnote_reference", "label", "reference_label"},
+};
+#define LOOKUP_COUNT (sizeof(lookups) / sizeof(lookups[0]))
+
+static LookupIds lookup_ids[LOOKUP_COUNT];
+
+static bool resolve_lookups(const TSLanguage *language) {
+  for (size_t i = 0; i < LOOKUP_COUNT; ++i) {
+    const Lookup *lookup = &lookups[i];
+    LookupIds *ids = &lookup_ids[i];
+    ids->parent = ts_language_symbol_for_name(language, lookup->parent,
+                                              strlen(lookup->parent), true);
+    ids->child = ts_language_symbol_for_name(language, lookup->child,
+                                             strlen(lookup->child), true);
+    ids->field = ts_language_field_id_for_name(language, lookup->field,
+                                               strlen(lookup->field));
+    if (!ids->field) {
+      fprintf(stderr, "no field `%s` in the language, regenerate the parser\n",
+              lookup->field);
+      return false;
+    }
+  }
+  return true;
+}
+
+static TSNode scan_for_child(TSNode node, TSSymbol symbol) {
+  uint32_t count = ts_node_named_child_count(node);
+  for (uint32_t i = 0; i < count; ++i) {
+    TSNode child = ts_node_named_child(node, i);
+    if (ts_node_symbol(child) == symbol) {
+      return child;
+    }
+  }
+  return (TSNode){0};
+}
+
+// Walk the whole tree like a renderer does, looking up the interesting child
+// of every node that has one. Returns the number of lookups and sums the
+// length of the children found, so both ways can be checked against each
+// other.
+static size_t consumer_walk(TSTree *tree, bool use_fields, size_t *bytes) {
+  size_t count = 0;
+  TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+  for (;;) {
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    TSSymbol symbol = ts_node_symbol(node);
+    for (size_t i = 0; i < LOOKUP_COUNT; ++i) {
+      if (lookup_ids[i].parent != symbol) {
+        continue;
+      }
+      TSNode child = use_fields
+                         ? ts_node_child_by_field_id(node, lookup_ids[i].field)
+                         : scan_for_child(node, lookup_ids[i].child);
+      if (!ts_node_is_null(child)) {
+        *bytes += ts_node_end_byte(child) - ts_node_start_byte(child);
+      }
+      ++count;
+    }
+
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      continue;
+    }
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) {
+        ts_tree_cursor_delete(&cursor);
+        return count;
+      }
+    }
+  }
+}
+
+static void bench_fields(const char *name, Buffer *document, int runs) {
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_djot());
+  TSTree *tree =
+      ts_parser_parse_string(parser, NULL, document->text, document->length);
+
+  double best[2] = {0, 0};
+  size_t count = 0, bytes[2] = {0, 0};
+  for (int r = 0; r < runs; ++r) {
+    for (int use_fields = 0; use_fields < 2; ++use_fields) {
+      bytes[use_fields] = 0;
+      double start = now();
+      count = consumer_walk(tree, use_fields, &bytes[use_fields]);
+      double elapsed = now() - start;
+      if (r == 0 || elapsed < best[use_fields]) {
+        best[use_fields] = elapsed;
+      }
+    }
+  }
+
+  printf("%-14s %9zu %9zu %10.3f %10.3f %8.2fx%s\n", name, document->length,
+         count, best[0] * 1e3, best[1] * 1e3, best[0] / best[1],
+         bytes[0] == bytes[1] ? "" : "  (results differ)");
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--forks") == 0) {
+    bench_forks(argc - 2, argv + 2);
+    return 0;
+  }
+
+  bool parse_only = argc > 1 && strcmp(argv[1], "--parse") == 0;
+  int edits = argc > 1 && !parse_only ? atoi(argv[1]) : 100;
+
+  Buffer mixed = {0}, nested = {0}, lists = {0};
+  generate_mixed(&mixed, 1000);
+  generate_nested(&nested, 16);
+  generate_lists(&lists);
+
+  Buffer line_starts = {0}, table = {0};
+  generate_line_starts(&line_starts);
+  generate_table(&table, 100000);
+
+  // The table size depends on the grammar, so print it with the timings.
+  const TSLanguage *language = tree_sitter_djot();
+  printf("Parse table: %u states, %u symbols\n\n",
+         ts_language_state_count(language),
+         ts_language_symbol_count(language));
+
+  printf("Parse from scratch\n");
+  printf("%-14s %9s %9s %9s %10s %10s %9s\n", "document", "bytes", "nodes",
+         "tokens", "parse ms", "MB/s", "ext adv/B");
+  bench_parse("mixed", &mixed, 5);
+  bench_parse("nested-16", &nested, 5);
+  bench_parse("lists", &lists, 5);
+  bench_parse("line-starts", &line_starts, 5);
+  bench_parse("table-100k", &table, 5);
+  free(line_starts.text);
+  free(table.text);
+
+  printf("\nWindows line endings\n");
+  printf("%-14s %9s %10s %10s %10s %9s %9s\n", "document", "bytes", "LF ms",
+         "CRLF ms", "input ms", "nodes", "nodes");
+  bench_crlf("mixed", &mixed, 5);
+  bench_crlf("lists", &lists, 5);
+
+  if (parse_only) {
+    free(mixed.text);
+    free(nested.text);
+    free(lists.text);
+    return 0;
+  }
+
+  if (resolve_lookups(tree_sitter_djot())) {
+    printf("\nConsumer walk looking up children by type or by field\n");
+    printf("%-14s %9s %9s %10s %10s %9s\n", "document", "bytes", "lookups",
+           "types ms", "fields ms", "speedup");
+    bench_fields("mixed", &mixed, 5);
+    bench_fields("nested-16", &nested, 5);
+  }
+
+  printf("\nIncremental reparse after typing a character\n");
+  printf("%-14s %9s %9s %10s %10s %10s %9s\n", "document", "bytes", "nodes",
+         "parse ms", "edit ms", "worst ms", "reused");
+  bench_incremental("mixed", &mixed, edits);
+  bench_incremental("nested-16", &nested, edits);
+  bench_incremental("lists", &lists, edits);
+
+  free(mixed.text);
+  free(nested.text);
+  free(lists.text);
+  return 0;
+}
@@ -0,0 +1,185 @@
+// Parse driver for the profile-guided build, see `make pgo`.
+//
+// Parses the inputs of the corpus files (`.txt`) and the documents (the
+// benchmark fixtures) given on the command line. It's the training run of the
+// instrumented build, and the measurement `make pgo` compares between the
+// release and the profile-guided build.
+//
+//   pgo_driver RUNS FILE...
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <tree_sitter/api.h>
+
+#include "documents.h"
+
+const TSLanguage *tree_sitter_djot(void);
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+  const char *text;
+  size_t length;
+} Input;
+
+typedef struct {
+  Input *inputs;
+  size_t count;
+  size_t capacity;
+  size_t bytes;
+} Inputs;
+
+static void add_input(Inputs *inputs, const char *text, size_t length) {
+  if (inputs->count == inputs->capacity) {
+    size_t capacity = inputs->capacity ? inputs->capacity * 2 : 64;
+    Input *grown = realloc(inputs->inputs, capacity * sizeof(*grown));
+    if (!grown) {
+      perror("realloc");
+      exit(1);
+    }
+    inputs->inputs = grown;
+    inputs->capacity = capacity;
+  }
+  inputs->inputs[inputs->count++] = (Input){text, length};
+  inputs->bytes += length;
+}
+
+static bool is_rule(const char *line, const char *end, char c) {
+  const char *p = line;
+  while (p < end && *p == c) {
+    ++p;
+  }
+  return p - line >= 3 && (p == end || *p == '\n' || *p == '\r');
+}
+
+static const char *next_line(const char *line, const char *end) {
+  const char *newline = memchr(line, '\n', end - line);
+  return newline ? newline + 1 : end;
+}
+
+// A corpus test is a `===` delimited name, the input and a `---` line
+// followed by the expected tree, which some tests leave out. As with
+// `tree-sitter test`, the last `---` line before the next test is the one
+// that ends the input, so inputs may have `---` lines of their own, like
+// frontmatter. Only the inputs are kept, pointing into `text`.
+static void split_corpus(Inputs *inputs, const char *text, size_t length) {
+  const char *end = text + length;
+  const char *line = text;
+  while (line < end) {
+    if (!is_rule(line, end, '=')) {
+      line = next_line(line, end);
+      continue;
+    }
+    // Skip the name and the closing `===` line of the header.
+    line = next_line(next_line(line, end), end);
+    line = next_line(line, end);
+    const char *input = line;
+    const char *divider = NULL;
+    while (line < end && !is_rule(line, end, '=')) {
+      if (is_rule(line, end, '-')) {
+        divider = line;
+      }
+      line = next_line(line, end);
+    }
+    add_input(inputs, input, (divider ? divider : line) - input);
+  }
+}
+
+static bool is_corpus_file(const char *path) {
+  size_t length = strlen(path);
+  return length >= 4 && strcmp(path + length - 4, ".txt") == 0;
+}
+
+static char *read_file(const char *path, size_t *length) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    perror(path);
+    exit(1);
+  }
+  Buffer buffer = {0};
+  char chunk[4096];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk) - 1, file)) > 0) {
+    chunk[read] = '\0';
+    append(&buffer, chunk);
+  }
+  fclose(file);
+  *length = buffer.length;
+  return buffer.text;
+}
+
+static double parse_all(TSParser *parser, const Inputs *inputs) {
+  double start = now();
+  for (size_t i = 0; i < inputs->count; ++i) {
+    const Input *input = &inputs->inputs[i];
+    ts_tree_delete(
+        ts_parser_parse_string(parser, NULL, input->text, input->length));
+  }
+  return now() - start;
+}
+
+static void run(TSParser *parser, const char *name, const Inputs *inputs,
+                int runs) {
+  double best = 0;
+  for (int r = 0; r < runs; ++r) {
+    double elapsed = parse_all(parser, inputs);
+    if (r == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  printf("%-14s %9zu %9zu %10.2f %10.2f\n", name, inputs->count,
+         inputs->bytes, best * 1e3, inputs->bytes / best / 1e6);
+}
+
+int main(int argc, char **argv) {
+  int runs = argc > 1 ? atoi(argv[1]) : 1;
+  if (runs < 1) {
+    runs = 1;
+  }
+
+  Inputs corpus = {0}, documents = {0};
+  char **files = calloc(argc, sizeof(*files));
+  if (!files) {
+    perror("calloc");
+    return 1;
+  }
+  for (int i = 2; i < argc; ++i) {
+    size_t length;
+    files[i] = read_file(argv[i], &length);
+    if (is_corpus_file(argv[i])) {
+      split_corpus(&corpus, files[i], length);
+    } else {
+      add_input(&documents, files[i], length);
+    }
+  }
+
+  TSParser *parser = ts_parser_new();
+  if (!ts_parser_set_language(parser, tree_sitter_djot())) {
+    fprintf(stderr, "the parser's ABI version isn't supported by the "
+                    "tree-sitter library\n");
+    return 1;
+  }
+
+  printf("%-14s %9s %9s %10s %10s\n", "inputs", "count", "bytes", "parse ms",
+         "MB/s");
+  run(parser, "corpus", &corpus, runs);
+  run(parser, "documents", &documents, runs);
+
+  ts_parser_delete(parser);
+  for (int i = 2; i < argc; ++i) {
+    free(files[i]);
+  }
+  free(files);
+  free(corpus.inputs);
+  free(documents.inputs);
+  return 0;
+}
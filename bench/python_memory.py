@@ -0,0 +1,116 @@
+"""Peak memory of parsing files read into bytes against mapping them.
+
+    TREE_SITTER_LIB=path/to/tree-sitter/lib pip install .
+    python bench/python_memory.py [--files N] [--size MB]
+
+Writes N documents of about MB megabytes each, the benchmark fixtures
+(`make fixtures`) repeated, to a temporary directory. Then it parses all of
+them in a fresh process per mode, one file at a time. The peak is the
+anonymous resident memory, sampled while the parser runs without the GIL.
+Pages of a mapped file are counted as file memory instead, which the kernel
+can drop and read back at any time. Linux only, as it reads /proc/self/status.
+"""
+
+import argparse
+import os
+import resource
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+FIXTURES = os.path.join(os.path.dirname(os.path.abspath(__file__)), "fixtures")
+
+
+def read_fixture(name):
+    with open(os.path.join(FIXTURES, name), "rb") as file:
+        return file.read()
+
+
+def write_document(path, size):
+    names = sorted(name for name in os.listdir(FIXTURES) if name.endswith(".dj"))
+    chunk = b"\n".join(read_fixture(name) for name in names)
+    with open(path, "wb") as file:
+        for _ in range(max(1, size // len(chunk))):
+            file.write(chunk)
+
+
+def anonymous_rss():
+    with open("/proc/self/status") as status:
+        for line in status:
+            if line.startswith("RssAnon:"):
+                return int(line.split()[1]) * 1024
+    return 0
+
+
+def run(mode, paths):
+    import tree_sitter_djot
+
+    peak = 0
+    done = threading.Event()
+
+    def sample():
+        nonlocal peak
+        while not done.is_set():
+            peak = max(peak, anonymous_rss())
+            time.sleep(0.002)
+
+    sampler = threading.Thread(target=sample)
+    sampler.start()
+    start = time.perf_counter()
+    rows = 0
+    for path in paths:
+        if mode == "read":
+            with open(path, "rb") as file:
+                table, _ = tree_sitter_djot.parse_table(file.read())
+        else:
+            table, _ = tree_sitter_djot.parse_file(path)
+        rows += table.shape[0]
+        del table
+    elapsed = time.perf_counter() - start
+    done.set()
+    sampler.join()
+
+    max_rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+    print(f"{mode} {elapsed} {peak} {max_rss} {rows}")
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--files", type=int, default=20)
+    parser.add_argument("--size", type=int, default=25, help="MB per file")
+    parser.add_argument("--mode", choices=["read", "mmap"])
+    parser.add_argument("paths", nargs="*")
+    args = parser.parse_args()
+
+    if args.mode:
+        run(args.mode, args.paths)
+        return
+
+    with tempfile.TemporaryDirectory() as directory:
+        paths = [os.path.join(directory, f"{i}.dj") for i in range(args.files)]
+        for path in paths:
+            write_document(path, args.size * 1000 * 1000)
+        total = sum(os.path.getsize(path) for path in paths)
+        print(f"{len(paths)} files, {total / 1e6:.0f} MB\n")
+        print(
+            f"{'mode':<6} {'s':>8} {'MB/s':>8} {'peak anon MB':>13} "
+            f"{'max RSS MB':>11}"
+        )
+        for mode in ["read", "mmap"]:
+            output = subprocess.run(
+                [sys.executable, __file__, "--mode", mode, *paths],
+                check=True,
+                capture_output=True,
+                text=True,
+            ).stdout.split()
+            elapsed, peak, max_rss = float(output[1]), int(output[2]), int(output[3])
+            print(
+                f"{mode:<6} {elapsed:8.2f} {total / elapsed / 1e6:8.2f} "
+                f"{peak / 1e6:13.1f} {max_rss / 1e6:11.1f}"
+            )
+
+
+if __name__ == "__main__":
+    main()
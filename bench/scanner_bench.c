@@ -0,0 +1,944 @@
+// Microbenchmarks for the external scanner.
+//
+// The scanner is compiled into this file and driven directly with an
+// in-memory lexer, the way tree-sitter drives it: the state of the previous
+// external token is deserialized before every scan, and the new state is
+// serialized after every token. When the scanner doesn't produce a token the
+// internal lexer is emulated by consuming a single character.
+//
+// There's no parser involved, so the valid symbols are approximated with
+// a small state machine over the previously returned token. The valid symbol
+// sets of the grammar itself are only used to measure the cost per set,
+// and are read from the language in `parser.c`.
+//
+// Build and run with `make bench`.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void *counting_malloc(size_t size);
+static void *counting_realloc(void *ptr, size_t size);
+static void counting_free(void *ptr);
+
+#define ts_malloc counting_malloc
+#define ts_realloc counting_realloc
+#define ts_free counting_free
+
+#include "../src/scanner.c"
+#include "documents.h"
+
+const TSLanguage *tree_sitter_djot(void);
+
+static uint64_t allocations = 0;
+
+static void *counting_malloc(size_t size) {
+  ++allocations;
+  return malloc(size);
+}
+
+static void *counting_realloc(void *ptr, size_t size) {
+  ++allocations;
+  return realloc(ptr, size);
+}
+
+static void counting_free(void *ptr) { free(ptr); }
+
+// Input
+
+typedef struct {
+  TSLexer lexer;
+  const char *text;
+  size_t length;
+  size_t position;
+  size_t token_end;
+  uint64_t advances;
+  uint64_t column_calls;
+} Input;
+
+static void input_advance(TSLexer *lexer, bool skip) {
+  Input *in = (Input *)lexer;
+  if (in->position < in->length) {
+    ++in->position;
+  }
+  ++in->advances;
+  lexer->lookahead =
+      in->position < in->length ? (unsigned char)in->text[in->position] : 0;
+}
+
+static void input_mark_end(TSLexer *lexer) {
+  Input *in = (Input *)lexer;
+  in->token_end = in->position;
+}
+
+// Like tree-sitter, finding the column walks back to the start of the line.
+static uint32_t input_get_column(TSLexer *lexer) {
+  Input *in = (Input *)lexer;
+  ++in->column_calls;
+  uint32_t column = 0;
+  size_t pos = in->position;
+  while (pos > 0 && in->text[pos - 1] != '\n') {
+    --pos;
+    ++column;
+  }
+  return column;
+}
+
+static bool input_eof(const TSLexer *lexer) {
+  const Input *in = (const Input *)lexer;
+  return in->position >= in->length;
+}
+
+static void input_reset(Input *in, size_t position) {
+  in->position = position;
+  in->token_end = position;
+  in->lexer.result_symbol = 0;
+  in->lexer.lookahead =
+      position < in->length ? (unsigned char)in->text[position] : 0;
+}
+
+// Valid symbols
+
+typedef enum {
+  CONTEXT_BLOCK,
+  CONTEXT_INLINE,
+  // Start of a line continuing a paragraph.
+  CONTEXT_INLINE_LINE,
+  // Start of the line after a paragraph.
+  CONTEXT_PARAGRAPH_END,
+  CONTEXT_VERBATIM_CONTENT,
+  CONTEXT_VERBATIM_END,
+} Context;
+
+static bool block_symbols[ERROR + 1];
+static bool inline_symbols[ERROR + 1];
+static bool inline_line_symbols[ERROR + 1];
+static bool paragraph_end_symbols[ERROR + 1];
+static bool verbatim_content_symbols[ERROR + 1];
+static bool verbatim_end_symbols[ERROR + 1];
+static bool continuation_symbols[ERROR + 1];
+static bool code_block_symbols[ERROR + 1];
+static bool table_cell_symbols[ERROR + 1];
+
+static void init_symbols(void) {
+  for (int i = BLOCK_CLOSE; i < ERROR; ++i) {
+    block_symbols[i] = true;
+  }
+  block_symbols[NEWLINE_INLINE] = false;
+  block_symbols[CLOSE_PARAGRAPH] = false;
+  block_symbols[VERBATIM_CONTENT] = false;
+  block_symbols[VERBATIM_END] = false;
+  block_symbols[CODE_BLOCK_CONTENT] = false;
+  // Only valid after a frontmatter marker, in a table row or in a paragraph,
+  // where they consume a lot more than a block scan would.
+  block_symbols[FRONTMATTER_CONTENT] = false;
+  block_symbols[TABLE_CELL_TEXT] = false;
+  block_symbols[UNCLOSED_SYMBOL] = false;
+
+  inline_symbols[NEWLINE] = true;
+  inline_symbols[NEWLINE_INLINE] = true;
+  inline_symbols[EOF_OR_BLANKLINE] = true;
+  inline_symbols[VERBATIM_BEGIN] = true;
+
+  memcpy(inline_line_symbols, inline_symbols, sizeof(inline_symbols));
+  inline_line_symbols[BLOCK_QUOTE_CONTINUATION] = true;
+
+  paragraph_end_symbols[EOF_OR_BLANKLINE] = true;
+  paragraph_end_symbols[CLOSE_PARAGRAPH] = true;
+
+  verbatim_content_symbols[VERBATIM_CONTENT] = true;
+  // Verbatim content may continue in another chunk.
+  verbatim_end_symbols[VERBATIM_CONTENT] = true;
+  verbatim_end_symbols[VERBATIM_END] = true;
+  continuation_symbols[BLOCK_QUOTE_CONTINUATION] = true;
+
+  code_block_symbols[CODE_BLOCK_CONTENT] = true;
+  code_block_symbols[BLOCK_CLOSE] = true;
+  code_block_symbols[BLOCK_QUOTE_CONTINUATION] = true;
+
+  table_cell_symbols[TABLE_CELL_TEXT] = true;
+  table_cell_symbols[VERBATIM_BEGIN] = true;
+  table_cell_symbols[UNCLOSED_SYMBOL] = true;
+}
+
+static Context next_context(Context context, TokenType token) {
+  switch (token) {
+  case NEWLINE:
+    return context == CONTEXT_INLINE || context == CONTEXT_INLINE_LINE
+               ? CONTEXT_PARAGRAPH_END
+               : CONTEXT_BLOCK;
+  case NEWLINE_INLINE:
+    return CONTEXT_INLINE_LINE;
+  case BLOCK_QUOTE_CONTINUATION:
+    return context == CONTEXT_INLINE_LINE ? CONTEXT_INLINE_LINE
+                                          : CONTEXT_BLOCK;
+  case VERBATIM_BEGIN:
+    return CONTEXT_VERBATIM_CONTENT;
+  case VERBATIM_CONTENT:
+    return CONTEXT_VERBATIM_END;
+  case VERBATIM_END:
+    return CONTEXT_INLINE;
+  default:
+    return CONTEXT_BLOCK;
+  }
+}
+
+// Driver
+
+typedef struct {
+  uint64_t scans;
+  uint64_t tokens;
+  uint64_t allocations;
+  uint64_t advances;
+  // Scans starting at the beginning of a line, and their advances.
+  uint64_t line_scans;
+  uint64_t line_advances;
+  uint64_t column_calls;
+  uint64_t state_bytes;
+  uint64_t max_state_bytes;
+  // Time spent in `scan`, and in `serialize` and `deserialize`.
+  double scan_seconds;
+  double state_seconds;
+} Stats;
+
+// The scanner state and position of every scan in a run.
+typedef struct {
+  size_t position;
+  unsigned length;
+  char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+} Snapshot;
+
+typedef Array(Snapshot) Snapshots;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void run_once(const char *text, size_t length, Stats *stats,
+                     Snapshots *snapshots) {
+  Input in = {
+      .lexer =
+          {
+              .advance = input_advance,
+              .mark_end = input_mark_end,
+              .get_column = input_get_column,
+              .eof = input_eof,
+          },
+      .text = text,
+      .length = length,
+  };
+  char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+  unsigned state_length = 0;
+  void *scanner = tree_sitter_djot_external_scanner_create();
+
+  Context context = CONTEXT_BLOCK;
+  // Zero-width tokens emitted at the current position, the parser wouldn't
+  // accept them again before consuming input.
+  bool emitted[ERROR + 1] = {false};
+  unsigned zero_width_tokens = 0;
+  size_t position = 0;
+
+  while (position <= length) {
+    const bool *symbols;
+    switch (context) {
+    case CONTEXT_BLOCK:
+      symbols = block_symbols;
+      break;
+    case CONTEXT_INLINE:
+      symbols = inline_symbols;
+      break;
+    case CONTEXT_INLINE_LINE:
+      symbols = inline_line_symbols;
+      break;
+    case CONTEXT_PARAGRAPH_END:
+      symbols = paragraph_end_symbols;
+      break;
+    case CONTEXT_VERBATIM_CONTENT:
+      symbols = verbatim_content_symbols;
+      break;
+    default:
+      symbols = verbatim_end_symbols;
+      break;
+    }
+    bool valid[ERROR + 1];
+    for (int i = 0; i <= ERROR; ++i) {
+      valid[i] = symbols[i] && !emitted[i];
+    }
+
+    if (snapshots) {
+      Snapshot snapshot = {.position = position, .length = state_length};
+      memcpy(snapshot.state, state, state_length);
+      array_push(snapshots, snapshot);
+    }
+
+    double start = now();
+    tree_sitter_djot_external_scanner_deserialize(scanner, state,
+                                                  state_length);
+    input_reset(&in, position);
+    ++stats->scans;
+
+    uint64_t advances_before = in.advances;
+    double scan_start = now();
+    bool found =
+        tree_sitter_djot_external_scanner_scan(scanner, &in.lexer, valid);
+    double scan_end = now();
+    stats->scan_seconds += scan_end - scan_start;
+    stats->state_seconds += scan_start - start;
+    if (position == 0 || text[position - 1] == '\n') {
+      ++stats->line_scans;
+      stats->line_advances += in.advances - advances_before;
+    }
+
+    if (found) {
+      TokenType token = in.lexer.result_symbol;
+      ++stats->tokens;
+      state_length = tree_sitter_djot_external_scanner_serialize(scanner, state);
+      stats->state_seconds += now() - scan_end;
+      stats->state_bytes += state_length;
+      if (state_length > stats->max_state_bytes) {
+        stats->max_state_bytes = state_length;
+      }
+
+      if (in.token_end > position) {
+        memset(emitted, 0, sizeof(emitted));
+        zero_width_tokens = 0;
+        position = in.token_end;
+      } else if (token != BLOCK_CLOSE || ++zero_width_tokens > 256) {
+        emitted[token] = true;
+      }
+      context = next_context(context, token);
+    } else if (position < length) {
+      // Emulate the internal lexer.
+      if (text[position] != ' ' && text[position] != '\n') {
+        context = CONTEXT_INLINE;
+      }
+      memset(emitted, 0, sizeof(emitted));
+      zero_width_tokens = 0;
+      ++position;
+    } else {
+      break;
+    }
+  }
+
+  tree_sitter_djot_external_scanner_destroy(scanner);
+  stats->advances += in.advances;
+  stats->column_calls += in.column_calls;
+}
+
+typedef struct {
+  const char *name;
+  Buffer document;
+} Workload;
+
+static void report(const Workload *w, const Stats *stats) {
+  double bytes = (double)w->document.length;
+  double seconds = stats->scan_seconds + stats->state_seconds;
+  printf("%-14s %9zu %8.1f %8.2f %8.1f %8.1f %10.2f %10.3f %10.2f %9.2f "
+         "%6llu\n",
+         w->name, w->document.length, bytes / seconds / 1e6, stats->scans / bytes,
+         stats->scan_seconds * 1e9 / stats->scans,
+         stats->state_seconds * 1e9 / stats->scans,
+         stats->allocations * 1000.0 / stats->scans, stats->advances / bytes,
+         (double)stats->line_advances / stats->line_scans,
+         (double)stats->state_bytes / stats->tokens,
+         (unsigned long long)stats->max_state_bytes);
+}
+
+// Reports the fastest of `runs` runs, to filter out noise.
+static void run(const Workload *w, int runs) {
+  Stats best = {0};
+  for (int i = 0; i <= runs; ++i) {
+    Stats stats = {0};
+    uint64_t allocations_before = allocations;
+    run_once(w->document.text, w->document.length, &stats, NULL);
+    stats.allocations = allocations - allocations_before;
+    // The first run is a warm up.
+    if (i == 1 || (i > 1 && stats.scan_seconds + stats.state_seconds <
+                                best.scan_seconds + best.state_seconds)) {
+      best = stats;
+    }
+  }
+  report(w, &best);
+}
+
+// Depth scaling
+
+// The generated documents can't keep many blocks open, since the emulated
+// parser accepts BLOCK_CLOSE almost everywhere. Instead start from a state
+// with a list and `depth` nested block quotes, and scan a line continuing
+// all of them: one BLOCK_QUOTE_CONTINUATION per `>`, each looking up its
+// block quote, followed by a block scan at the start of the text that looks
+// for the list.
+static void run_depth(int depth, int runs) {
+  Buffer line = {0};
+  for (int i = 0; i < depth; ++i) {
+    append(&line, "> ");
+  }
+  append(&line, "text\n");
+
+  Scanner *scanner = tree_sitter_djot_external_scanner_create();
+  push_block(scanner, LIST_DASH, 2);
+  for (int level = 1; level <= depth; ++level) {
+    push_block(scanner, BLOCK_QUOTE, level);
+  }
+  char initial[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+  unsigned initial_length =
+      tree_sitter_djot_external_scanner_serialize(scanner, initial);
+
+  Input in = {
+      .lexer =
+          {
+              .advance = input_advance,
+              .mark_end = input_mark_end,
+              .get_column = input_get_column,
+              .eof = input_eof,
+          },
+      .text = line.text,
+      .length = line.length,
+  };
+  // Enough lines for a stable measurement at every depth.
+  const int lines = 100000 / (depth + 1);
+
+  Stats best = {0};
+  for (int r = 0; r <= runs; ++r) {
+    Stats stats = {0};
+    char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+    for (int l = 0; l < lines; ++l) {
+      memcpy(state, initial, initial_length);
+      unsigned state_length = initial_length;
+      size_t position = 0;
+      for (;;) {
+        double start = now();
+        tree_sitter_djot_external_scanner_deserialize(scanner, state,
+                                                      state_length);
+        input_reset(&in, position);
+        double scan_start = now();
+        const bool *symbols =
+            line.text[position] == '>' ? continuation_symbols : block_symbols;
+        bool found =
+            tree_sitter_djot_external_scanner_scan(scanner, &in.lexer, symbols);
+        double scan_end = now();
+        ++stats.scans;
+        stats.scan_seconds += scan_end - scan_start;
+        stats.state_seconds += scan_start - start;
+        if (!found || in.lexer.result_symbol != BLOCK_QUOTE_CONTINUATION) {
+          break;
+        }
+        state_length =
+            tree_sitter_djot_external_scanner_serialize(scanner, state);
+        stats.state_seconds += now() - scan_end;
+        position = in.token_end;
+      }
+    }
+    if (r == 1 || (r > 1 && stats.scan_seconds + stats.state_seconds <
+                                best.scan_seconds + best.state_seconds)) {
+      best = stats;
+    }
+  }
+
+  printf("%-14d %9llu %8.1f %8.1f %9u\n", depth,
+         (unsigned long long)best.scans,
+         best.scan_seconds * 1e9 / best.scans,
+         best.state_seconds * 1e9 / best.scans, initial_length);
+
+  tree_sitter_djot_external_scanner_destroy(scanner);
+  free(line.text);
+}
+
+// Cost per valid symbol set
+
+typedef struct {
+  uint16_t id;
+  int symbols;
+  double seconds;
+  uint64_t scans;
+} SymbolSet;
+
+static int compare_cost(const void *a, const void *b) {
+  const SymbolSet *x = a, *y = b;
+  double cx = x->seconds / x->scans, cy = y->seconds / y->scans;
+  return (cx < cy) - (cx > cy);
+}
+
+// Repeat every scan of a document with each of the grammar's valid symbol
+// sets, from the scanner state the scan had in the emulated parse.
+// Reports the most expensive sets, and the mean over all sets.
+static void run_symbol_sets(int runs) {
+  const TSLanguage *language = tree_sitter_djot();
+  uint16_t set_count = 0;
+  for (uint32_t i = 0; i < language->state_count; ++i) {
+    uint16_t id = language->lex_modes[i].external_lex_state;
+    if (id >= set_count) {
+      set_count = id + 1;
+    }
+  }
+
+  Buffer document = {0};
+  generate_mixed(&document, 20);
+  Snapshots snapshots = array_new();
+  Stats unused = {0};
+  run_once(document.text, document.length, &unused, &snapshots);
+
+  Input in = {
+      .lexer =
+          {
+              .advance = input_advance,
+              .mark_end = input_mark_end,
+              .get_column = input_get_column,
+              .eof = input_eof,
+          },
+      .text = document.text,
+      .length = document.length,
+  };
+  void *scanner = tree_sitter_djot_external_scanner_create();
+
+  // The set with id 0 has no valid symbols, tree-sitter doesn't call the
+  // scanner with it.
+  SymbolSet *sets = calloc(set_count, sizeof(SymbolSet));
+  for (uint16_t id = 1; id < set_count; ++id) {
+    const bool *valid_symbols =
+        language->external_scanner.states +
+        id * language->external_token_count;
+    sets[id].id = id;
+    for (uint32_t i = 0; i < language->external_token_count; ++i) {
+      sets[id].symbols += valid_symbols[i];
+    }
+
+    // Timing single scans would mostly measure the clock, so time all of
+    // them and subtract the time it takes to restore the states.
+    double restore = 0;
+    for (int r = 0; r <= runs; ++r) {
+      for (int scan = 0; scan < 2; ++scan) {
+        double start = now();
+        for (uint32_t i = 0; i < snapshots.size; ++i) {
+          Snapshot *snapshot = array_get(&snapshots, i);
+          tree_sitter_djot_external_scanner_deserialize(
+              scanner, snapshot->state, snapshot->length);
+          input_reset(&in, snapshot->position);
+          if (scan) {
+            tree_sitter_djot_external_scanner_scan(scanner, &in.lexer,
+                                                   valid_symbols);
+          }
+        }
+        double seconds = now() - start;
+        double *best = scan ? &sets[id].seconds : &restore;
+        if (r == 1 || (r > 1 && seconds < *best)) {
+          *best = seconds;
+        }
+      }
+    }
+    sets[id].seconds -= restore;
+    sets[id].scans = snapshots.size;
+  }
+
+  double total = 0;
+  for (uint16_t id = 1; id < set_count; ++id) {
+    total += sets[id].seconds * 1e9 / sets[id].scans;
+  }
+  qsort(sets + 1, set_count - 1, sizeof(SymbolSet), compare_cost);
+  for (uint16_t i = 1; i < set_count && i <= 10; ++i) {
+    printf("%-14u %9d %8.1f\n", sets[i].id, sets[i].symbols,
+           sets[i].seconds * 1e9 / sets[i].scans);
+  }
+  printf("%-14s %9s %8.1f\n", "mean", "", total / (set_count - 1));
+
+  free(sets);
+  tree_sitter_djot_external_scanner_destroy(scanner);
+  array_delete(&snapshots);
+  free(document.text);
+}
+
+// Line length scaling
+
+// Scan every newline of a paragraph with lines of `line_length` bytes,
+// as the parser would, with the text in between lexed internally.
+static void run_line_length(int line_length, int runs) {
+  Buffer document = {0};
+  generate_long_lines(&document, 2000000 / line_length, line_length);
+
+  Input in = {
+      .lexer =
+          {
+              .advance = input_advance,
+              .mark_end = input_mark_end,
+              .get_column = input_get_column,
+              .eof = input_eof,
+          },
+      .text = document.text,
+      .length = document.length,
+  };
+  void *scanner = tree_sitter_djot_external_scanner_create();
+
+  Stats best = {0};
+  for (int r = 0; r <= runs; ++r) {
+    Stats stats = {0};
+    char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+    unsigned state_length = 0;
+    in.advances = 0;
+    in.column_calls = 0;
+    for (size_t position = 0; position < document.length; ++position) {
+      if (document.text[position] != '\n') {
+        continue;
+      }
+      double start = now();
+      tree_sitter_djot_external_scanner_deserialize(scanner, state,
+                                                    state_length);
+      input_reset(&in, position);
+      double scan_start = now();
+      tree_sitter_djot_external_scanner_scan(scanner, &in.lexer,
+                                             inline_symbols);
+      double scan_end = now();
+      state_length =
+          tree_sitter_djot_external_scanner_serialize(scanner, state);
+      ++stats.scans;
+      stats.scan_seconds += scan_end - scan_start;
+      stats.state_seconds += now() - scan_end + scan_start - start;
+    }
+    stats.advances = in.advances;
+    stats.column_calls = in.column_calls;
+    if (r == 1 || (r > 1 && stats.scan_seconds + stats.state_seconds <
+                                best.scan_seconds + best.state_seconds)) {
+      best = stats;
+    }
+  }
+
+  printf("%-14d %9llu %8.1f %8.1f %9.2f %9llu\n", line_length,
+         (unsigned long long)best.scans,
+         best.scan_seconds * 1e9 / best.scans,
+         best.state_seconds * 1e9 / best.scans,
+         (double)best.advances / best.scans,
+         (unsigned long long)best.column_calls);
+
+  tree_sitter_djot_external_scanner_destroy(scanner);
+  free(document.text);
+}
+
+// Unclosed verbatim
+
+// Scan the content of a verbatim that's never closed, in a paragraph of
+// `bytes` bytes. Tree-sitter can only stop a parse between tokens, so the
+// slowest scan bounds how long a parse may overrun its timeout.
+static void run_unclosed_verbatim(int bytes, int runs) {
+  Buffer document = {0};
+  append(&document, "`");
+  generate_long_lines(&document, bytes / 80, 80);
+
+  Input in = {
+      .lexer =
+          {
+              .advance = input_advance,
+              .mark_end = input_mark_end,
+              .get_column = input_get_column,
+              .eof = input_eof,
+          },
+      .text = document.text,
+      .length = document.length,
+  };
+  void *scanner = tree_sitter_djot_external_scanner_create();
+  input_reset(&in, 0);
+  tree_sitter_djot_external_scanner_scan(scanner, &in.lexer, inline_symbols);
+  char initial[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+  unsigned initial_length =
+      tree_sitter_djot_external_scanner_serialize(scanner, initial);
+  size_t content_start = in.token_end;
+
+  Stats best = {0};
+  double best_worst = 0;
+  size_t largest = 0;
+  for (int r = 0; r <= runs; ++r) {
+    Stats stats = {0};
+    double worst = 0;
+    char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+    memcpy(state, initial, initial_length);
+    unsigned state_length = initial_length;
+    const bool *symbols = verbatim_content_symbols;
+    size_t position = content_start;
+    for (;;) {
+      tree_sitter_djot_external_scanner_deserialize(scanner, state,
+                                                    state_length);
+      input_reset(&in, position);
+      double start = now();
+      bool found =
+          tree_sitter_djot_external_scanner_scan(scanner, &in.lexer, symbols);
+      double elapsed = now() - start;
+      ++stats.scans;
+      stats.scan_seconds += elapsed;
+      if (elapsed > worst) {
+        worst = elapsed;
+      }
+      if (!found || in.lexer.result_symbol != VERBATIM_CONTENT) {
+        break;
+      }
+      ++stats.tokens;
+      if (in.token_end - position > largest) {
+        largest = in.token_end - position;
+      }
+      state_length =
+          tree_sitter_djot_external_scanner_serialize(scanner, state);
+      position = in.token_end;
+      symbols = verbatim_end_symbols;
+    }
+    if (r == 1 || (r > 1 && worst < best_worst)) {
+      best = stats;
+      best_worst = worst;
+    }
+  }
+
+  printf("%-14zu %9llu %9zu %10.2f %10.3f\n", document.length,
+         (unsigned long long)best.tokens, largest, best_worst * 1e6,
+         best.scan_seconds * 1e3);
+
+  tree_sitter_djot_external_scanner_destroy(scanner);
+  free(document.text);
+}
+
+// Code blocks
+
+// Scan the content of a code block of `lines` lines.
+static void run_code_block(int lines, int runs) {
+  Buffer document = {0};
+  append(&document, "```c\n");
+  for (int i = 0; i < lines; ++i) {
+    append(&document, i % 4 ? "  x = f(x, `y`);\n" : "\n");
+  }
+  append(&document, "```\n");
+
+  Input in = {
+      .lexer =
+          {
+              .advance = input_advance,
+              .mark_end = input_mark_end,
+              .get_column = input_get_column,
+              .eof = input_eof,
+          },
+      .text = document.text,
+      .length = document.length,
+  };
+  void *scanner = tree_sitter_djot_external_scanner_create();
+  input_reset(&in, 0);
+  tree_sitter_djot_external_scanner_scan(scanner, &in.lexer, block_symbols);
+  char initial[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+  unsigned initial_length =
+      tree_sitter_djot_external_scanner_serialize(scanner, initial);
+  size_t content_start = strchr(document.text, '\n') - document.text + 1;
+
+  Stats best = {0};
+  for (int r = 0; r <= runs; ++r) {
+    Stats stats = {0};
+    char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+    memcpy(state, initial, initial_length);
+    unsigned state_length = initial_length;
+    size_t position = content_start;
+    for (;;) {
+      tree_sitter_djot_external_scanner_deserialize(scanner, state,
+                                                    state_length);
+      input_reset(&in, position);
+      double start = now();
+      bool found = tree_sitter_djot_external_scanner_scan(scanner, &in.lexer,
+                                                          code_block_symbols);
+      stats.scan_seconds += now() - start;
+      ++stats.scans;
+      if (!found || in.lexer.result_symbol != CODE_BLOCK_CONTENT) {
+        break;
+      }
+      ++stats.tokens;
+      state_length =
+          tree_sitter_djot_external_scanner_serialize(scanner, state);
+      position = in.token_end;
+    }
+    if (r == 1 || (r > 1 && stats.scan_seconds < best.scan_seconds)) {
+      best = stats;
+    }
+  }
+
+  printf("%-14d %9zu %9llu %9.4f %10.3f\n", lines, document.length,
+         (unsigned long long)best.tokens, (double)best.tokens / lines,
+         best.scan_seconds * 1e3);
+
+  tree_sitter_djot_external_scanner_destroy(scanner);
+  free(document.text);
+}
+
+// Tables
+
+// The tokens of a cell lexed with the inline rules: runs of plain text and
+// whitespace, and every other character on its own.
+static size_t inline_cell_tokens(const char *text, size_t length) {
+  size_t tokens = 0;
+  int previous = 0;
+  for (size_t i = 0; i < length; ++i) {
+    char c = text[i];
+    int kind = c == ' '                                        ? 1
+               : is_plain_cell_char(c) && c != '.' && c != '-' ? 2
+                                                               : 3;
+    if (kind == 3 || kind != previous) {
+      ++tokens;
+    }
+    previous = kind;
+  }
+  return tokens;
+}
+
+// Scan the cells of a table. Cells that aren't a single token are counted
+// as the inline rules would lex them.
+//
+// As in a parse, a cell is scanned with the state of the last cell token of
+// its row, and the first cell of a row with the state of the table.
+static void run_table(const char *name, Buffer document, int runs) {
+  Input in = {
+      .lexer =
+          {
+              .advance = input_advance,
+              .mark_end = input_mark_end,
+              .get_column = input_get_column,
+              .eof = input_eof,
+          },
+      .text = document.text,
+      .length = document.length,
+  };
+  void *scanner = tree_sitter_djot_external_scanner_create();
+  char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+  unsigned state_length =
+      tree_sitter_djot_external_scanner_serialize(scanner, state);
+  char row_state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+  unsigned row_state_length = 0;
+
+  Stats best = {0};
+  size_t cells = 0, tokens = 0, inline_tokens = 0;
+  for (int r = 0; r <= runs; ++r) {
+    Stats stats = {0};
+    cells = tokens = inline_tokens = 0;
+    for (size_t position = 0; position < document.length; ++position) {
+      if (position == 0 || document.text[position - 1] == '\n') {
+        memcpy(row_state, state, state_length);
+        row_state_length = state_length;
+      }
+      if (document.text[position] != '|' ||
+          document.text[position + 1] == '\n') {
+        continue;
+      }
+      size_t cell_start = position + 1;
+      size_t cell_end = strchr(document.text + cell_start, '|') - document.text;
+      ++cells;
+      inline_tokens +=
+          inline_cell_tokens(document.text + cell_start, cell_end - cell_start);
+
+      tree_sitter_djot_external_scanner_deserialize(scanner, row_state,
+                                                    row_state_length);
+      input_reset(&in, cell_start);
+      double start = now();
+      bool found = tree_sitter_djot_external_scanner_scan(scanner, &in.lexer,
+                                                          table_cell_symbols);
+      stats.scan_seconds += now() - start;
+      ++stats.scans;
+      if (found && in.lexer.result_symbol == TABLE_CELL_TEXT) {
+        ++tokens;
+        row_state_length =
+            tree_sitter_djot_external_scanner_serialize(scanner, row_state);
+      } else {
+        tokens += inline_cell_tokens(document.text + cell_start,
+                                     cell_end - cell_start);
+      }
+    }
+    if (r == 1 || (r > 1 && stats.scan_seconds < best.scan_seconds)) {
+      best = stats;
+    }
+  }
+
+  printf("%-14s %9zu %9zu %9zu %9zu %10.3f\n", name, document.length, cells,
+         inline_tokens, tokens, best.scan_seconds * 1e3);
+
+  tree_sitter_djot_external_scanner_destroy(scanner);
+  free(document.text);
+}
+
+int main(int argc, char **argv) {
+  int runs = argc > 1 ? atoi(argv[1]) : 20;
+  init_symbols();
+
+  Workload workloads[] = {
+      {.name = "prose"},     {.name = "lists"},     {.name = "line-starts"},
+      {.name = "nested-4"},  {.name = "nested-16"}, {.name = "nested-64"},
+  };
+  generate_prose(&workloads[0].document);
+  generate_lists(&workloads[1].document);
+  generate_line_starts(&workloads[2].document);
+  generate_nested(&workloads[3].document, 4);
+  generate_nested(&workloads[4].document, 16);
+  generate_nested(&workloads[5].document, 64);
+
+  printf("%-14s %9s %8s %8s %8s %8s %10s %10s %10s %9s %6s\n", "workload",
+         "bytes", "MB/s", "scans/B", "ns/scan", "ns/state", "allocs/1k", "advance/B",
+         "adv/line", "state/tok", "state");
+  for (size_t i = 0; i < sizeof(workloads) / sizeof(*workloads); ++i) {
+    run(&workloads[i], runs);
+    free(workloads[i].document.text);
+  }
+
+  printf("\nLine inside nested block quotes\n");
+  printf("%-14s %9s %8s %8s %9s\n", "depth", "scans", "ns/scan", "ns/state",
+         "state");
+  const int depths[] = {1, 4, 16, 64, 128, 255};
+  for (size_t i = 0; i < sizeof(depths) / sizeof(*depths); ++i) {
+    run_depth(depths[i], runs);
+  }
+
+  printf("\nEvery scan of a document, by valid symbol set\n");
+  printf("%-14s %9s %8s\n", "set", "symbols", "ns/scan");
+  run_symbol_sets(runs);
+
+  printf("\nNewlines in a paragraph with long lines\n");
+  printf("%-14s %9s %8s %8s %9s %9s\n", "line bytes", "scans", "ns/scan",
+         "ns/state", "advances", "columns");
+  const int line_lengths[] = {100, 1000, 10000, 100000};
+  for (size_t i = 0; i < sizeof(line_lengths) / sizeof(*line_lengths); ++i) {
+    run_line_length(line_lengths[i], runs);
+  }
+
+  printf("\nUnclosed verbatim in a paragraph\n");
+  printf("%-14s %9s %9s %10s %10s\n", "bytes", "tokens", "largest",
+         "worst us", "total ms");
+  const int verbatim_bytes[] = {10000, 100000, 1000000, 10000000};
+  for (size_t i = 0; i < sizeof(verbatim_bytes) / sizeof(*verbatim_bytes);
+       ++i) {
+    run_unclosed_verbatim(verbatim_bytes[i], runs);
+  }
+
+  printf("\nCode block content\n");
+  printf("%-14s %9s %9s %9s %10s\n", "lines", "bytes", "tokens", "tok/line",
+         "total ms");
+  const int code_lines[] = {1000, 10000, 50000};
+  for (size_t i = 0; i < sizeof(code_lines) / sizeof(*code_lines); ++i) {
+    run_code_block(code_lines[i], runs);
+  }
+
+  printf("\nTable cells\n");
+  printf("%-14s %9s %9s %9s %9s %10s\n", "rows x columns", "bytes",
+         "cells", "inline", "tokens", "scan ms");
+  const int table_rows[] = {1000, 100000};
+  for (size_t i = 0; i < sizeof(table_rows) / sizeof(*table_rows); ++i) {
+    Buffer document = {0};
+    generate_table(&document, table_rows[i]);
+    char name[32];
+    snprintf(name, sizeof(name), "%d x 4", table_rows[i]);
+    run_table(name, document, runs);
+  }
+  // The same number of cells, in ever wider rows.
+  const int table_columns[] = {8, 64, 512};
+  for (size_t i = 0; i < sizeof(table_columns) / sizeof(*table_columns);
+       ++i) {
+    int rows = 32768 / table_columns[i];
+    Buffer document = {0};
+    generate_wide_table(&document, rows, table_columns[i]);
+    char name[32];
+    snprintf(name, sizeof(name), "%d x %d", rows, table_columns[i]);
+    run_table(name, document, runs);
+  }
+  return 0;
+}
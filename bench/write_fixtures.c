@@ -0,0 +1,57 @@
+// Writes the generated documents of documents.h to files, the fixture set
+// the benchmarks of the bindings and the PGO training run read. See
+// `make fixtures`.
+//
+//   write_fixtures DIRECTORY
+
+#include <stdio.h>
+
+#include "documents.h"
+
+static int write_fixture(const char *directory, const char *name,
+                         const Buffer *document) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/%s.dj", directory, name);
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    perror(path);
+    return 1;
+  }
+  size_t written = fwrite(document->text, 1, document->length, file);
+  if (fclose(file) != 0 || written != document->length) {
+    perror(path);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s DIRECTORY\n", argv[0]);
+    return 2;
+  }
+
+  Buffer mixed = {0}, prose = {0}, nested = {0}, lists = {0},
+         line_starts = {0}, table = {0};
+  generate_mixed(&mixed, 200);
+  generate_prose(&prose);
+  generate_nested(&nested, 16);
+  generate_lists(&lists);
+  generate_line_starts(&line_starts);
+  generate_table(&table, 1000);
+
+  int failed = write_fixture(argv[1], "mixed", &mixed) |
+               write_fixture(argv[1], "prose", &prose) |
+               write_fixture(argv[1], "nested-16", &nested) |
+               write_fixture(argv[1], "lists", &lists) |
+               write_fixture(argv[1], "line-starts", &line_starts) |
+               write_fixture(argv[1], "table", &table);
+
+  free(mixed.text);
+  free(prose.text);
+  free(nested.text);
+  free(lists.text);
+  free(line_starts.text);
+  free(table.text);
+  return failed;
+}
@@ -1,4 +1,11 @@
 {
+  "variables": {
+    # The batch parse API compiles its own copy of the tree-sitter runtime,
+    # from TREE_SITTER_LIB or the sources that the `tree-sitter` package,
+    # node-tree-sitter, vendors. The build fails without either. Results are
+    # returned as arrays, so no tree crosses between the two runtimes.
+    "tree_sitter_lib": "<!(node bindings/node/tree-sitter-runtime.js)",
+  },
   "targets": [
     {
       "target_name": "tree_sitter_djot_binding",
@@ -7,11 +14,19 @@
       ],
       "include_dirs": [
         "src",
+        "<(tree_sitter_lib)/include",
+        "<(tree_sitter_lib)/src",
       ],
       "sources": [
         "bindings/node/binding.cc",
+        "bindings/node/batch.cc",
         "src/parser.c",
-        # NOTE: if your language has an external scanner, add it here.
+        "src/scanner.c",
+        "<(tree_sitter_lib)/src/lib.c",
+      ],
+      "defines": [
+        # The runtime uses POSIX functions, which -std=c11 hides.
+        "_DEFAULT_SOURCE",
       ],
       "cflags_c": [
         "-std=c11",
@@ -0,0 +1,220 @@
+#ifndef TREE_SITTER_DJOT_CRLF_H_
+#define TREE_SITTER_DJOT_CRLF_H_
+
+// A `TSInput` that presents text with Windows line endings to the parser as
+// LF-only text, without copying the document.
+//
+// Every `\r` directly before a `\n` is left out. The tree is then in
+// normalized coordinates and the functions below map bytes and points back
+// and forth. Rows are the same in both, columns only differ for the `\n` of
+// a CRLF.
+//
+//   DjotCrlfInput *input = djot_crlf_input_new(text, length);
+//   TSTree *tree = ts_parser_parse(parser, NULL, djot_crlf_input(input));
+//   uint32_t start = djot_crlf_original_byte(input, ts_node_start_byte(node));
+//
+// The text isn't copied and has to outlive the input. After editing it, pass
+// the edit in original coordinates to `djot_crlf_input_edit`, which converts
+// it for `ts_tree_edit`.
+//
+// `djot_crlf_input_new` returns NULL and the other functions that take a new
+// text return false when out of memory. The input can then only be deleted.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tree_sitter/api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DJOT_CRLF_CHUNK_SIZE 4096
+
+typedef struct {
+  const char *text;
+  uint32_t length;
+  // Original offsets of the left out `\r`s, in order.
+  uint32_t *removed;
+  uint32_t removed_count;
+  uint32_t removed_capacity;
+  char chunk[DJOT_CRLF_CHUNK_SIZE];
+} DjotCrlfInput;
+
+static inline bool djot_crlf_input_reset(DjotCrlfInput *self, const char *text,
+                                         uint32_t length) {
+  self->text = text;
+  self->length = length;
+  self->removed_count = 0;
+  const char *end = text + length;
+  for (const char *cr = memchr(text, '\r', length); cr;
+       cr = memchr(cr + 1, '\r', end - cr - 1)) {
+    if (cr + 1 == end) {
+      break;
+    }
+    if (cr[1] != '\n') {
+      continue;
+    }
+    if (self->removed_count == self->removed_capacity) {
+      uint32_t capacity =
+          self->removed_capacity ? self->removed_capacity * 2 : 64;
+      uint32_t *removed =
+          (uint32_t *)realloc(self->removed, capacity * sizeof(uint32_t));
+      if (!removed) {
+        self->removed_count = 0;
+        return false;
+      }
+      self->removed = removed;
+      self->removed_capacity = capacity;
+    }
+    self->removed[self->removed_count++] = (uint32_t)(cr - text);
+  }
+  return true;
+}
+
+static inline void djot_crlf_input_delete(DjotCrlfInput *self);
+
+static inline DjotCrlfInput *djot_crlf_input_new(const char *text,
+                                                 uint32_t length) {
+  DjotCrlfInput *self = (DjotCrlfInput *)calloc(1, sizeof(DjotCrlfInput));
+  if (!self) {
+    return NULL;
+  }
+  if (!djot_crlf_input_reset(self, text, length)) {
+    djot_crlf_input_delete(self);
+    return NULL;
+  }
+  return self;
+}
+
+static inline void djot_crlf_input_delete(DjotCrlfInput *self) {
+  free(self->removed);
+  free(self);
+}
+
+// The number of left out `\r`s before a normalized byte. The `\n` of the
+// i:th CRLF is at `removed[i] - i` in normalized text.
+static inline uint32_t djot_crlf_removed_before(const DjotCrlfInput *self,
+                                                uint32_t byte) {
+  uint32_t low = 0, high = self->removed_count;
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if (self->removed[mid] - mid <= byte) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+// The original byte of the character at a normalized byte. The end of a
+// node before a CRLF maps to its `\n`, so the range includes the `\r`.
+static inline uint32_t djot_crlf_original_byte(const DjotCrlfInput *self,
+                                               uint32_t byte) {
+  return byte + djot_crlf_removed_before(self, byte);
+}
+
+// The normalized byte of an original byte. Both bytes of a CRLF map to its
+// `\n`.
+static inline uint32_t djot_crlf_normalized_byte(const DjotCrlfInput *self,
+                                                 uint32_t byte) {
+  uint32_t low = 0, high = self->removed_count;
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if (self->removed[mid] < byte) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return byte - low;
+}
+
+static inline TSPoint djot_crlf_original_point(const DjotCrlfInput *self,
+                                               uint32_t byte, TSPoint point) {
+  uint32_t before = djot_crlf_removed_before(self, byte);
+  if (before > 0 && self->removed[before - 1] - (before - 1) == byte) {
+    ++point.column;
+  }
+  return point;
+}
+
+static inline TSPoint djot_crlf_normalized_point(const DjotCrlfInput *self,
+                                                 uint32_t byte, TSPoint point) {
+  if (byte > 0 && byte < self->length && self->text[byte] == '\n' &&
+      self->text[byte - 1] == '\r') {
+    --point.column;
+  }
+  return point;
+}
+
+static inline const char *djot_crlf_input_read(void *payload, uint32_t byte,
+                                               TSPoint position,
+                                               uint32_t *bytes_read) {
+  (void)position;
+  DjotCrlfInput *self = (DjotCrlfInput *)payload;
+  uint32_t from = djot_crlf_original_byte(self, byte);
+  uint32_t next = djot_crlf_removed_before(self, byte);
+  uint32_t size = 0;
+  while (from < self->length && size < DJOT_CRLF_CHUNK_SIZE) {
+    uint32_t until = next < self->removed_count ? self->removed[next]
+                                                : self->length;
+    uint32_t count = until - from;
+    if (count > DJOT_CRLF_CHUNK_SIZE - size) {
+      count = DJOT_CRLF_CHUNK_SIZE - size;
+    }
+    memcpy(self->chunk + size, self->text + from, count);
+    size += count;
+    from += count;
+    if (from == until && until < self->length) {
+      // Skip the `\r`.
+      ++from;
+      ++next;
+    }
+  }
+  *bytes_read = size;
+  return self->chunk;
+}
+
+static inline TSInput djot_crlf_input(DjotCrlfInput *self) {
+  TSInput input = {self, djot_crlf_input_read, TSInputEncodingUTF8};
+  return input;
+}
+
+// Switch to the edited text and convert the edit to normalized coordinates.
+// An edit right after a `\r` can join it with a `\n` or split them, so the
+// `\r` is included in the edit.
+static inline bool djot_crlf_input_edit(DjotCrlfInput *self, const char *text,
+                                        uint32_t length, TSInputEdit *edit) {
+  uint32_t start_byte = edit->start_byte;
+  TSPoint start_point = edit->start_point;
+  if (start_byte > 0 && start_byte <= self->length &&
+      self->text[start_byte - 1] == '\r') {
+    --start_byte;
+    --start_point.column;
+  }
+
+  TSInputEdit normalized;
+  normalized.start_byte = djot_crlf_normalized_byte(self, start_byte);
+  normalized.start_point =
+      djot_crlf_normalized_point(self, start_byte, start_point);
+  normalized.old_end_byte = djot_crlf_normalized_byte(self, edit->old_end_byte);
+  normalized.old_end_point =
+      djot_crlf_normalized_point(self, edit->old_end_byte, edit->old_end_point);
+  if (!djot_crlf_input_reset(self, text, length)) {
+    return false;
+  }
+  normalized.new_end_byte = djot_crlf_normalized_byte(self, edit->new_end_byte);
+  normalized.new_end_point =
+      djot_crlf_normalized_point(self, edit->new_end_byte, edit->new_end_point);
+  *edit = normalized;
+  return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TREE_SITTER_DJOT_CRLF_H_
@@ -0,0 +1,99 @@
+package tree_sitter_djot
+
+import (
+	"context"
+	"runtime"
+	"sync"
+
+	sitter "github.com/smacker/go-tree-sitter"
+)
+
+// Result is the tree of one input of Pool.ParseAll. Index is the position of
+// the input, as results arrive in the order they finish.
+type Result struct {
+	Index int
+	Tree  *sitter.Tree
+	Err   error
+}
+
+// Pool keeps a fixed set of Djot parsers and parses inputs concurrently, one
+// goroutine for each parser. Parsers are reused between inputs, so their
+// allocations are too.
+type Pool struct {
+	parsers chan *sitter.Parser
+}
+
+// NewPool creates a pool of size parsers. Size is limited to GOMAXPROCS, as
+// more parsers can't run at once, and defaults to it if it's not positive.
+func NewPool(size int) *Pool {
+	if procs := runtime.GOMAXPROCS(0); size <= 0 || size > procs {
+		size = procs
+	}
+	language := sitter.NewLanguage(Language())
+	pool := &Pool{parsers: make(chan *sitter.Parser, size)}
+	for i := 0; i < size; i++ {
+		parser := sitter.NewParser()
+		parser.SetLanguage(language)
+		pool.parsers <- parser
+	}
+	return pool
+}
+
+// Size is the number of parsers in the pool.
+func (p *Pool) Size() int {
+	return cap(p.parsers)
+}
+
+// Parse parses a single input with the next free parser.
+func (p *Pool) Parse(ctx context.Context, input []byte) (*sitter.Tree, error) {
+	select {
+	case parser := <-p.parsers:
+		defer func() { p.parsers <- parser }()
+		return parser.ParseCtx(ctx, nil, input)
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+// ParseAll parses the inputs on all parsers of the pool and sends a Result
+// for each of them. The channel is closed after the last one. The inputs
+// must not be modified until then. The caller owns the trees and has to
+// close them.
+func (p *Pool) ParseAll(ctx context.Context, inputs [][]byte) <-chan Result {
+	results := make(chan Result, len(inputs))
+	next := make(chan int)
+	go func() {
+		defer close(next)
+		for i := range inputs {
+			next <- i
+		}
+	}()
+
+	workers := p.Size()
+	if workers > len(inputs) {
+		workers = len(inputs)
+	}
+	var wg sync.WaitGroup
+	wg.Add(workers)
+	for w := 0; w < workers; w++ {
+		go func() {
+			defer wg.Done()
+			for i := range next {
+				tree, err := p.Parse(ctx, inputs[i])
+				results <- Result{Index: i, Tree: tree, Err: err}
+			}
+		}()
+	}
+	go func() {
+		wg.Wait()
+		close(results)
+	}()
+	return results
+}
+
+// Close deletes the parsers. The pool must not be in use.
+func (p *Pool) Close() {
+	for i := 0; i < cap(p.parsers); i++ {
+		(<-p.parsers).Close()
+	}
+}
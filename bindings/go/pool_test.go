@@ -0,0 +1,100 @@
+package tree_sitter_djot_test
+
+import (
+	"context"
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"testing"
+
+	"github.com/tree-sitter/tree-sitter-djot"
+)
+
+// fixtures reads the benchmark fixtures, see `make fixtures`, copies times
+// each, so there are more inputs than parsers.
+func fixtures(tb testing.TB, copies int) [][]byte {
+	paths, err := filepath.Glob(filepath.Join("..", "..", "bench", "fixtures", "*.dj"))
+	if err != nil {
+		tb.Fatal(err)
+	}
+	if len(paths) == 0 {
+		tb.Fatal("no fixtures in bench/fixtures, run `make fixtures`")
+	}
+	var inputs [][]byte
+	for _, path := range paths {
+		input, err := os.ReadFile(path)
+		if err != nil {
+			tb.Fatal(err)
+		}
+		for i := 0; i < copies; i++ {
+			inputs = append(inputs, input)
+		}
+	}
+	return inputs
+}
+
+func TestPoolParseAll(t *testing.T) {
+	pool := tree_sitter_djot.NewPool(0)
+	defer pool.Close()
+
+	inputs := fixtures(t, 3)
+	seen := make([]bool, len(inputs))
+	for result := range pool.ParseAll(context.Background(), inputs) {
+		if result.Err != nil {
+			t.Fatalf("input %d: %v", result.Index, result.Err)
+		}
+		root := result.Tree.RootNode()
+		if root.Type() != "document" || root.HasError() {
+			t.Errorf("input %d: %s", result.Index, root)
+		}
+		if int(root.EndByte()) != len(inputs[result.Index]) {
+			t.Errorf("input %d: tree ends at %d, not %d", result.Index,
+				root.EndByte(), len(inputs[result.Index]))
+		}
+		seen[result.Index] = true
+		result.Tree.Close()
+	}
+	for i, ok := range seen {
+		if !ok {
+			t.Errorf("no result for input %d", i)
+		}
+	}
+}
+
+// BenchmarkPool parses the same documents with 1 to GOMAXPROCS parsers and
+// reports docs/s, to show how parsing scales with cores.
+//
+//	go test -bench Pool -benchtime 10x
+func BenchmarkPool(b *testing.B) {
+	inputs := fixtures(b, 16)
+	var bytes int64
+	for _, input := range inputs {
+		bytes += int64(len(input))
+	}
+
+	procs := runtime.GOMAXPROCS(0)
+	sizes := []int{}
+	for size := 1; size < procs; size *= 2 {
+		sizes = append(sizes, size)
+	}
+	sizes = append(sizes, procs)
+
+	for _, size := range sizes {
+		b.Run(fmt.Sprintf("parsers=%d", size), func(b *testing.B) {
+			pool := tree_sitter_djot.NewPool(size)
+			defer pool.Close()
+			b.SetBytes(bytes)
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				for result := range pool.ParseAll(context.Background(), inputs) {
+					if result.Err != nil {
+						b.Fatal(result.Err)
+					}
+					result.Tree.Close()
+				}
+			}
+			b.ReportMetric(float64(b.N*len(inputs))/b.Elapsed().Seconds(), "docs/s")
+		})
+	}
+}
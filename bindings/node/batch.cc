@@ -0,0 +1,206 @@
+#include <napi.h>
+#include <tree_sitter/api.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" TSLanguage *tree_sitter_djot();
+
+namespace {
+
+// Every named node is four numbers in the flat array, in pre-order: the
+// symbol, start byte, end byte and the index of the parent node.
+const uint32_t NO_PARENT = UINT32_MAX;
+
+struct Document {
+  const char *text;
+  uint32_t length;
+  std::vector<uint32_t> nodes;
+  bool has_error;
+};
+
+void Flatten(TSTree *tree, std::vector<uint32_t> &nodes) {
+  TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+  std::vector<uint32_t> parents{NO_PARENT};
+  for (;;) {
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    uint32_t index = parents.back();
+    if (ts_node_is_named(node)) {
+      index = static_cast<uint32_t>(nodes.size() / 4);
+      nodes.insert(nodes.end(),
+                   {ts_node_symbol(node), ts_node_start_byte(node),
+                    ts_node_end_byte(node), parents.back()});
+    }
+
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      parents.push_back(index);
+      continue;
+    }
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) {
+        ts_tree_cursor_delete(&cursor);
+        return;
+      }
+      parents.pop_back();
+    }
+  }
+}
+
+// The documents of one `parseBatch` call, shared by its workers. The input
+// array is referenced so its buffers stay alive until all workers are done.
+struct Batch {
+  Batch(Napi::Env env, Napi::Array input)
+      : deferred(Napi::Promise::Deferred::New(env)),
+        input(Napi::Persistent(input)) {}
+
+  Napi::Promise::Deferred deferred;
+  Napi::Reference<Napi::Array> input;
+  std::vector<Document> documents;
+  std::atomic<size_t> next{0};
+  size_t pending_workers = 0;
+  std::string error;
+};
+
+Napi::Array Results(Napi::Env env, Batch &batch) {
+  Napi::Array results = Napi::Array::New(env, batch.documents.size());
+  for (size_t i = 0; i < batch.documents.size(); ++i) {
+    Document &document = batch.documents[i];
+    auto nodes = Napi::Uint32Array::New(env, document.nodes.size());
+    std::copy(document.nodes.begin(), document.nodes.end(), nodes.Data());
+    Napi::Object result = Napi::Object::New(env);
+    result["nodes"] = nodes;
+    result["hasError"] = Napi::Boolean::New(env, document.has_error);
+    results[static_cast<uint32_t>(i)] = result;
+    std::vector<uint32_t>().swap(document.nodes);
+  }
+  return results;
+}
+
+// The parser of the current thread pool thread, created by the first batch
+// that runs on it and kept for the later ones. Null if the runtime doesn't
+// support the parser's ABI version.
+TSParser *ThreadParser() {
+  thread_local std::unique_ptr<TSParser, void (*)(TSParser *)> parser(
+      nullptr, ts_parser_delete);
+  if (!parser) {
+    parser.reset(ts_parser_new());
+    if (!ts_parser_set_language(parser.get(), tree_sitter_djot())) {
+      parser.reset();
+    }
+  }
+  return parser.get();
+}
+
+// A worker on the libuv thread pool, parsing with the parser of its thread.
+// The workers of a batch take the next unparsed document until there are
+// none left.
+class ParseWorker : public Napi::AsyncWorker {
+ public:
+  ParseWorker(Napi::Env env, std::shared_ptr<Batch> batch)
+      : Napi::AsyncWorker(env), batch_(std::move(batch)) {}
+
+  void Execute() override {
+    TSParser *parser = ThreadParser();
+    if (!parser) {
+      SetError("the parser's ABI version isn't supported by the tree-sitter "
+               "runtime");
+      return;
+    }
+    for (size_t i = batch_->next++; i < batch_->documents.size();
+         i = batch_->next++) {
+      Document &document = batch_->documents[i];
+      TSTree *tree = ts_parser_parse_string(parser, nullptr, document.text,
+                                            document.length);
+      document.has_error = ts_node_has_error(ts_tree_root_node(tree));
+      Flatten(tree, document.nodes);
+      ts_tree_delete(tree);
+    }
+  }
+
+  void OnOK() override { Finish(); }
+
+  void OnError(const Napi::Error &error) override {
+    if (batch_->error.empty()) {
+      batch_->error = error.Message();
+    }
+    Finish();
+  }
+
+ private:
+  // The last worker of the batch settles its promise.
+  void Finish() {
+    if (--batch_->pending_workers > 0) {
+      return;
+    }
+    if (batch_->error.empty()) {
+      batch_->deferred.Resolve(Results(Env(), *batch_));
+    } else {
+      batch_->deferred.Reject(Napi::Error::New(Env(), batch_->error).Value());
+    }
+  }
+
+  std::shared_ptr<Batch> batch_;
+};
+
+// parseBatch(buffers, {threads}) parses the buffers on the thread pool and
+// resolves with `{nodes, hasError}` for each of them.
+Napi::Value ParseBatch(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    throw Napi::TypeError::New(env, "parseBatch expects an array of Buffers");
+  }
+  Napi::Array input = info[0].As<Napi::Array>();
+
+  uint32_t threads = 4;
+  if (info.Length() > 1 && info[1].IsObject()) {
+    Napi::Value value = info[1].As<Napi::Object>().Get("threads");
+    if (value.IsNumber()) {
+      threads = value.As<Napi::Number>().Uint32Value();
+    }
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+
+  auto batch = std::make_shared<Batch>(env, input);
+  batch->documents.resize(input.Length());
+  for (uint32_t i = 0; i < input.Length(); ++i) {
+    Napi::Value value = input[i];
+    if (!value.IsBuffer()) {
+      throw Napi::TypeError::New(env, "parseBatch expects an array of Buffers");
+    }
+    auto buffer = value.As<Napi::Buffer<char>>();
+    batch->documents[i].text = buffer.Data();
+    batch->documents[i].length = static_cast<uint32_t>(buffer.Length());
+  }
+
+  Napi::Promise promise = batch->deferred.Promise();
+  if (batch->documents.empty()) {
+    batch->deferred.Resolve(Napi::Array::New(env));
+    return promise;
+  }
+  if (threads > batch->documents.size()) {
+    threads = static_cast<uint32_t>(batch->documents.size());
+  }
+  batch->pending_workers = threads;
+  for (uint32_t i = 0; i < threads; ++i) {
+    (new ParseWorker(env, batch))->Queue();
+  }
+  return promise;
+}
+
+} // namespace
+
+void InitBatch(Napi::Env env, Napi::Object exports) {
+  const TSLanguage *language = tree_sitter_djot();
+  uint32_t count = ts_language_symbol_count(language);
+  Napi::Array names = Napi::Array::New(env, count);
+  for (uint32_t i = 0; i < count; ++i) {
+    names[i] = Napi::String::New(env, ts_language_symbol_name(language, i));
+  }
+  exports["symbolNames"] = names;
+  exports["parseBatch"] = Napi::Function::New(env, ParseBatch, "parseBatch");
+}
@@ -4,6 +4,8 @@ typedef struct TSLanguage TSLanguage;
 
 extern "C" TSLanguage *tree_sitter_djot();
 
+void InitBatch(Napi::Env env, Napi::Object exports);
+
 // "tree-sitter", "language" hashed with BLAKE2
 const napi_type_tag LANGUAGE_TYPE_TAG = {
   0x8AF2E5212AD58ABF, 0xD5006CAD83ABBA16
@@ -14,6 +16,7 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     auto language = Napi::External<TSLanguage>::New(env, tree_sitter_djot());
     language.TypeTag(&LANGUAGE_TYPE_TAG);
     exports["language"] = language;
+    InitBatch(env, exports);
     return exports;
 }
 
@@ -0,0 +1,65 @@
+const assert = require("node:assert");
+const { test } = require("node:test");
+const Parser = require("tree-sitter");
+const Djot = require(".");
+
+const documents = [
+  "# Heading\n\nSome _emphasis_, *strong* and `verbatim` text.\n\n- a\n- b\n",
+  "> quote\n\n| a | b |\n|---|---|\n| c | d |\n",
+  "---\nkey: value\n",
+  "",
+].map((text) => Buffer.from(text));
+
+// The named nodes of a tree, as `parseBatch` returns them.
+function rows(tree) {
+  const result = [];
+  const visit = (node, parent) => {
+    const index = result.length;
+    result.push([node.type, node.startIndex, node.endIndex, parent]);
+    for (const child of node.namedChildren) {
+      visit(child, index);
+    }
+  };
+  visit(tree.rootNode, 0xffffffff);
+  return result;
+}
+
+function batchRows({ nodes }) {
+  const result = [];
+  for (let i = 0; i < nodes.length; i += 4) {
+    const [symbol, start, end, parent] = nodes.subarray(i, i + 4);
+    result.push([Djot.symbolNames[symbol], start, end, parent]);
+  }
+  return result;
+}
+
+test("can load grammar", () => {
+  const parser = new Parser();
+  assert.doesNotThrow(() => parser.setLanguage(Djot));
+});
+
+test("parseBatch matches Parser.parse", async () => {
+  const parser = new Parser();
+  parser.setLanguage(Djot);
+  const results = await Djot.parseBatch(documents);
+  assert.strictEqual(results.length, documents.length);
+  documents.forEach((document, i) => {
+    const tree = parser.parse(document.toString());
+    assert.deepStrictEqual(batchRows(results[i]), rows(tree));
+    assert.strictEqual(results[i].hasError, tree.rootNode.hasError);
+  });
+  assert.strictEqual(results[2].hasError, true);
+});
+
+test("parseBatch gives the same trees on any number of threads", async () => {
+  const many = Array.from({ length: 16 }, () => documents).flat();
+  const single = await Djot.parseBatch(many, { threads: 1 });
+  const pooled = await Djot.parseBatch(many, { threads: 4 });
+  assert.deepStrictEqual(pooled.map(batchRows), single.map(batchRows));
+});
+
+test("parseBatch takes only arrays of Buffers", async () => {
+  assert.deepStrictEqual(await Djot.parseBatch([]), []);
+  assert.throws(() => Djot.parseBatch("text"), TypeError);
+  assert.throws(() => Djot.parseBatch(["text"]), TypeError);
+});
@@ -18,10 +18,27 @@ type NodeInfo =
       children: ChildNode[];
     });
 
+// Every named node is four numbers in `nodes`, in pre-order: the index in
+// `symbolNames` of its type, the start byte, the end byte and the index of
+// the parent node, which is 0xffffffff for the root.
+type BatchResult = {
+  nodes: Uint32Array;
+  hasError: boolean;
+};
+
+type BatchOptions = {
+  threads?: number;
+};
+
 type Language = {
   name: string;
   language: unknown;
   nodeTypeInfo: NodeInfo[];
+  symbolNames: string[];
+  parseBatch: (
+    documents: Buffer[],
+    options?: BatchOptions,
+  ) => Promise<BatchResult[]>;
 };
 
 declare const language: Language;
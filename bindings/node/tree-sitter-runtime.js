@@ -0,0 +1,34 @@
+// Where binding.gyp finds the sources of the tree-sitter runtime for the
+// batch parse API: the `lib` directory in TREE_SITTER_LIB, or the one that
+// the `tree-sitter` package vendors. Fails when there's neither, which
+// stops node-gyp.
+//
+//   node bindings/node/tree-sitter-runtime.js
+
+const fs = require("fs");
+const path = require("path");
+
+function find() {
+  if (process.env.TREE_SITTER_LIB) {
+    return path.resolve(process.env.TREE_SITTER_LIB);
+  }
+  let dir;
+  try {
+    dir = path.dirname(require.resolve("tree-sitter/package.json"));
+  } catch (_) {
+    return "";
+  }
+  const lib = path.join(dir, "vendor", "tree-sitter", "lib");
+  return fs.existsSync(path.join(lib, "src", "lib.c")) ? lib : "";
+}
+
+const lib = find();
+if (!lib) {
+  console.error(
+    "tree-sitter-djot: no tree-sitter runtime sources for parseBatch. " +
+      "Install `tree-sitter`, or set TREE_SITTER_LIB to the lib directory " +
+      "of a tree-sitter checkout.",
+  );
+  process.exit(1);
+}
+console.log(lib);
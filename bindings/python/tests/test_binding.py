@@ -0,0 +1,129 @@
+import mmap
+import os
+import sys
+import tempfile
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from unittest import TestCase, skipIf
+
+import tree_sitter_djot
+
+DOCUMENT = b"# Heading\n\nSome _emphasis_, *strong* and `verbatim` text.\n\n- a\n- b\n"
+
+
+@skipIf(not hasattr(tree_sitter_djot, "parse_table"), "not built on Windows")
+class TestParseTable(TestCase):
+    def test_rows_are_a_2d_uint32_buffer(self):
+        table, has_error = tree_sitter_djot.parse_table(DOCUMENT)
+        self.assertFalse(has_error)
+        self.assertEqual(table.ndim, 2)
+        self.assertEqual(table.format, "I")
+        self.assertEqual(table.itemsize, 4)
+        self.assertEqual(table.shape[1], 4)
+        self.assertEqual(table.strides, (16, 4))
+        self.assertTrue(table.readonly)
+
+    def test_rows_are_the_named_nodes_in_pre_order(self):
+        table, _ = tree_sitter_djot.parse_table(DOCUMENT)
+        names = tree_sitter_djot.symbol_names()
+        rows = table.tolist()
+        self.assertEqual(names[rows[0][0]], "document")
+        self.assertEqual(rows[0][1:], [0, len(DOCUMENT), 0xFFFFFFFF])
+        types = [names[symbol] for symbol, _, _, _ in rows]
+        self.assertEqual(types.count("list_item"), 2)
+        self.assertIn("emphasis", types)
+        for index, (_, start, end, parent) in enumerate(rows[1:], 1):
+            self.assertLess(parent, index)
+            self.assertGreaterEqual(start, rows[parent][1])
+            self.assertLessEqual(end, rows[parent][2])
+
+    def test_errors(self):
+        _, has_error = tree_sitter_djot.parse_table(b"---\nkey: value\n")
+        self.assertTrue(has_error)
+
+    def test_empty_document(self):
+        table, has_error = tree_sitter_djot.parse_table(b"")
+        self.assertFalse(has_error)
+        self.assertEqual(table.tolist(), [[table[0, 0], 0, 0, 0xFFFFFFFF]])
+
+    def test_bytes_like_objects(self):
+        expected = tree_sitter_djot.parse_table(DOCUMENT)[0].tolist()
+        with tempfile.TemporaryFile() as file:
+            file.write(DOCUMENT)
+            file.flush()
+            with mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                mapped = tree_sitter_djot.parse_table(data)[0].tolist()
+        self.assertEqual(mapped, expected)
+        for data in [bytearray(DOCUMENT), memoryview(DOCUMENT)]:
+            self.assertEqual(tree_sitter_djot.parse_table(data)[0].tolist(), expected)
+        with self.assertRaises(TypeError):
+            tree_sitter_djot.parse_table("text")
+
+    def test_releases_the_gil(self):
+        # Another thread only runs during the parse if the GIL is released,
+        # the switch interval keeps it from running anywhere else.
+        document = DOCUMENT * 5000
+        ticks = 0
+        done = threading.Event()
+
+        def tick():
+            nonlocal ticks
+            while not done.is_set():
+                ticks += 1
+                time.sleep(0)
+
+        interval = sys.getswitchinterval()
+        sys.setswitchinterval(10)
+        ticker = threading.Thread(target=tick)
+        ticker.start()
+        try:
+            before = ticks
+            tree_sitter_djot.parse_table(document)
+            during = ticks - before
+        finally:
+            done.set()
+            ticker.join()
+            sys.setswitchinterval(interval)
+        self.assertGreater(during, 0)
+
+    def test_threads(self):
+        documents = [DOCUMENT * count for count in range(1, 65)]
+        expected = [tree_sitter_djot.parse_table(document)[0].tolist() for document in documents]
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            tables = list(pool.map(tree_sitter_djot.parse_table, documents))
+        self.assertEqual([table.tolist() for table, _ in tables], expected)
+
+
+@skipIf(not hasattr(tree_sitter_djot, "parse_file"), "not built on Windows")
+class TestParseFile(TestCase):
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.addCleanup(self.directory.cleanup)
+
+    def write(self, text):
+        path = os.path.join(self.directory.name, "document.dj")
+        with open(path, "wb") as file:
+            file.write(text)
+        return path
+
+    def test_matches_parse_table(self):
+        path = self.write(DOCUMENT)
+        table, has_error = tree_sitter_djot.parse_file(path)
+        self.assertFalse(has_error)
+        self.assertEqual(table.shape[1], 4)
+        self.assertEqual(table.tolist(), tree_sitter_djot.parse_table(DOCUMENT)[0].tolist())
+        self.assertEqual(tree_sitter_djot.parse_file(path.encode())[0].tolist(), table.tolist())
+
+    def test_empty_file(self):
+        table, has_error = tree_sitter_djot.parse_file(self.write(b""))
+        self.assertFalse(has_error)
+        self.assertEqual(table.tolist(), tree_sitter_djot.parse_table(b"")[0].tolist())
+
+    def test_missing_file(self):
+        with self.assertRaises(FileNotFoundError):
+            tree_sitter_djot.parse_file(os.path.join(self.directory.name, "missing.dj"))
+
+    def test_directory(self):
+        with self.assertRaises(IsADirectoryError):
+            tree_sitter_djot.parse_file(self.directory.name)
@@ -1,5 +1,34 @@
 "Djot grammar for tree-sitter"
 
+from . import _binding
 from ._binding import language
 
 __all__ = ["language"]
+
+if hasattr(_binding, "parse_table"):
+
+    def _table(result):
+        rows, has_error = result
+        return memoryview(rows).cast("I", (len(rows) // 16, 4)), has_error
+
+    def parse_table(data):
+        """Parse a bytes-like object into a table of its named nodes.
+
+        The GIL is released while parsing, so documents can be parsed
+        concurrently from a thread pool, each thread with a parser of its
+        own. `bytes` is read in place and other bytes-like objects are
+        copied once. Returns the table and whether the tree has errors.
+        The table is a 2-D memoryview of uint32 rows of `(symbol, start_byte,
+        end_byte, parent_index)` in pre-order, which `numpy.asarray` takes
+        without a copy. The parent of the root is 0xffffffff and
+        `symbol_names()[symbol]` is the type of a node.
+        """
+        return _table(_binding.parse_table(data))
+
+    def parse_file(path):
+        """Parse a file like `parse_table`, mapping it instead of reading it."""
+        return _table(_binding.parse_file(path))
+
+    from ._binding import symbol_names
+
+    __all__ += ["parse_table", "parse_file", "symbol_names"]
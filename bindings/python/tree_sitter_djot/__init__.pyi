@@ -1 +1,9 @@
+import os
+from typing import List, Tuple, Union
+
 def language() -> int: ...
+
+# Not built on Windows, see setup.py.
+def parse_table(data: Union[bytes, bytearray, memoryview]) -> Tuple[memoryview, bool]: ...
+def parse_file(path: Union[str, bytes, os.PathLike]) -> Tuple[memoryview, bool]: ...
+def symbol_names() -> List[str]: ...
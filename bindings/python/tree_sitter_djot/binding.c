@@ -8,9 +8,281 @@ static PyObject* _binding_language(PyObject *self, PyObject *args) {
     return PyLong_FromVoidPtr(tree_sitter_djot());
 }
 
+#ifdef TREE_SITTER_DJOT_TABLE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tree_sitter/api.h>
+#include <unistd.h>
+
+// Every thread parses with a parser of its own, created on its first parse
+// and deleted when the thread exits.
+static pthread_key_t parser_key;
+
+static void delete_parser(void *parser) {
+    ts_parser_delete(parser);
+}
+
+static TSParser *thread_parser(void) {
+    TSParser *parser = pthread_getspecific(parser_key);
+    if (parser) {
+        return parser;
+    }
+    parser = ts_parser_new();
+    if (!ts_parser_set_language(parser, tree_sitter_djot())) {
+        ts_parser_delete(parser);
+        PyErr_SetString(PyExc_RuntimeError,
+                        "the parser's ABI version isn't supported by the tree-sitter runtime");
+        return NULL;
+    }
+    if (pthread_setspecific(parser_key, parser) != 0) {
+        ts_parser_delete(parser);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    return parser;
+}
+
+// Every named node is a row of four uint32 in pre-order: the symbol, start
+// byte, end byte and the row of the parent node.
+#define NO_PARENT UINT32_MAX
+
+typedef struct {
+    uint32_t *rows;
+    size_t size;
+    size_t capacity;
+} Table;
+
+static int table_push(Table *table, uint32_t symbol, uint32_t start,
+                      uint32_t end, uint32_t parent) {
+    if (table->size + 4 > table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 1024;
+        uint32_t *rows = realloc(table->rows, capacity * sizeof(uint32_t));
+        if (!rows) {
+            return 0;
+        }
+        table->rows = rows;
+        table->capacity = capacity;
+    }
+    uint32_t *row = table->rows + table->size;
+    row[0] = symbol;
+    row[1] = start;
+    row[2] = end;
+    row[3] = parent;
+    table->size += 4;
+    return 1;
+}
+
+// Flattens the named nodes of a tree. The stack holds the nearest named
+// ancestor for every level of the cursor.
+static int flatten(TSTree *tree, Table *table) {
+    int ok = 1;
+    size_t depth = 0, stack_capacity = 64;
+    uint32_t *stack = malloc(stack_capacity * sizeof(uint32_t));
+    if (!stack) {
+        return 0;
+    }
+    stack[0] = NO_PARENT;
+
+    TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+    for (;;) {
+        TSNode node = ts_tree_cursor_current_node(&cursor);
+        uint32_t row = stack[depth];
+        if (ts_node_is_named(node)) {
+            row = (uint32_t)(table->size / 4);
+            if (!table_push(table, ts_node_symbol(node),
+                            ts_node_start_byte(node),
+                            ts_node_end_byte(node), stack[depth])) {
+                ok = 0;
+                break;
+            }
+        }
+
+        if (ts_tree_cursor_goto_first_child(&cursor)) {
+            if (++depth == stack_capacity) {
+                stack_capacity *= 2;
+                uint32_t *grown = realloc(stack, stack_capacity * sizeof(uint32_t));
+                if (!grown) {
+                    ok = 0;
+                    break;
+                }
+                stack = grown;
+            }
+            stack[depth] = row;
+            continue;
+        }
+        while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+            if (!ts_tree_cursor_goto_parent(&cursor)) {
+                goto done;
+            }
+            --depth;
+        }
+    }
+
+done:
+    ts_tree_cursor_delete(&cursor);
+    free(stack);
+    return ok;
+}
+
+typedef struct {
+    const char *text;
+    uint32_t length;
+} Document;
+
+// Gives the parser the rest of the document from `byte`, without a copy.
+static const char *read_document(void *payload, uint32_t byte,
+                                 TSPoint position, uint32_t *bytes_read) {
+    const Document *document = payload;
+    if (byte >= document->length) {
+        *bytes_read = 0;
+        return "";
+    }
+    *bytes_read = document->length - byte;
+    return document->text + byte;
+}
+
+// Parses a document with the GIL released and returns its rows as bytes,
+// which the package casts to a 2-D memoryview, and whether the tree has
+// errors. The parser reads the document in place, so it has to stay alive
+// and unchanged until this returns.
+static PyObject *parse(const char *text, Py_ssize_t length) {
+    if ((size_t)length > UINT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "document is larger than 4 GiB");
+        return NULL;
+    }
+    TSParser *parser = thread_parser();
+    if (!parser) {
+        return NULL;
+    }
+
+    Document document = {text, (uint32_t)length};
+    TSInput input = {
+        .payload = &document,
+        .read = read_document,
+        .encoding = TSInputEncodingUTF8,
+    };
+    Table table = {NULL, 0, 0};
+    int ok, has_error;
+    Py_BEGIN_ALLOW_THREADS
+    TSTree *tree = ts_parser_parse(parser, NULL, input);
+    has_error = ts_node_has_error(ts_tree_root_node(tree));
+    ok = flatten(tree, &table);
+    ts_tree_delete(tree);
+    Py_END_ALLOW_THREADS
+
+    if (!ok) {
+        free(table.rows);
+        return PyErr_NoMemory();
+    }
+    PyObject *rows = PyBytes_FromStringAndSize((const char *)table.rows,
+                                               table.size * sizeof(uint32_t));
+    free(table.rows);
+    if (!rows) {
+        return NULL;
+    }
+    return Py_BuildValue("(NO)", rows, has_error ? Py_True : Py_False);
+}
+
+// `bytes` is parsed in place. The limited API of Python 3.8 has no buffer
+// protocol, so any other bytes-like object is copied into `bytes` first.
+// `parse_file` maps files instead.
+static PyObject* _binding_parse_table(PyObject *self, PyObject *args) {
+    PyObject *data;
+    if (!PyArg_ParseTuple(args, "O:parse_table", &data)) {
+        return NULL;
+    }
+    PyObject *bytes = PyBytes_FromObject(data);
+    if (!bytes) {
+        return NULL;
+    }
+    char *text;
+    Py_ssize_t length;
+    PyObject *result = NULL;
+    if (PyBytes_AsStringAndSize(bytes, &text, &length) == 0) {
+        result = parse(text, length);
+    }
+    Py_DECREF(bytes);
+    return result;
+}
+
+// Maps the file read-only and parses the mapping, so it's never read into
+// memory as a whole. An empty file can't be mapped and is parsed as "".
+static PyObject* _binding_parse_file(PyObject *self, PyObject *args) {
+    PyObject *path;
+    if (!PyArg_ParseTuple(args, "O&:parse_file", PyUnicode_FSConverter, &path)) {
+        return NULL;
+    }
+    int fd = open(PyBytes_AsString(path), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+        Py_DECREF(path);
+        return NULL;
+    }
+    struct stat info;
+    int error = fstat(fd, &info) != 0 ? errno
+                : S_ISDIR(info.st_mode) ? EISDIR
+                                        : 0;
+    if (error) {
+        errno = error;
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+        close(fd);
+        Py_DECREF(path);
+        return NULL;
+    }
+
+    PyObject *result;
+    if (info.st_size == 0) {
+        result = parse("", 0);
+    } else {
+        void *text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text == MAP_FAILED) {
+            PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+            close(fd);
+            Py_DECREF(path);
+            return NULL;
+        }
+        result = parse(text, info.st_size);
+        munmap(text, info.st_size);
+    }
+    close(fd);
+    Py_DECREF(path);
+    return result;
+}
+
+static PyObject* _binding_symbol_names(PyObject *self, PyObject *args) {
+    const TSLanguage *language = tree_sitter_djot();
+    uint32_t count = ts_language_symbol_count(language);
+    PyObject *names = PyList_New(count);
+    if (!names) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        PyObject *name = PyUnicode_FromString(ts_language_symbol_name(language, i));
+        if (!name) {
+            Py_DECREF(names);
+            return NULL;
+        }
+        PyList_SetItem(names, i, name);
+    }
+    return names;
+}
+#endif
+
 static PyMethodDef methods[] = {
     {"language", _binding_language, METH_NOARGS,
      "Get the tree-sitter language for this grammar."},
+#ifdef TREE_SITTER_DJOT_TABLE
+    {"parse_table", _binding_parse_table, METH_VARARGS,
+     "Parse a bytes-like object without the GIL into rows of named nodes."},
+    {"parse_file", _binding_parse_file, METH_VARARGS,
+     "Parse a mapped file without the GIL into rows of named nodes."},
+    {"symbol_names", _binding_symbol_names, METH_NOARGS,
+     "Get the node type names, indexed by symbol."},
+#endif
     {NULL, NULL, 0, NULL}
 };
 
@@ -23,5 +295,10 @@ static struct PyModuleDef module = {
 };
 
 PyMODINIT_FUNC PyInit__binding(void) {
+#ifdef TREE_SITTER_DJOT_TABLE
+    if (pthread_key_create(&parser_key, delete_parser) != 0) {
+        return PyErr_NoMemory();
+    }
+#endif
     return PyModule_Create(&module);
 }
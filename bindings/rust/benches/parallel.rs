@@ -0,0 +1,59 @@
+//! Throughput of `parse_many` on the benchmark fixtures with 1, 2, 4 ...
+//! threads, up to the available parallelism.
+//!
+//!     cargo bench --features parallel
+
+use std::fs;
+use std::path::{Path, PathBuf};
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+/// Each fixture is parsed this many times, so there are enough documents to
+/// spread over the threads.
+const COPIES: usize = 32;
+
+/// The benchmark fixtures, see `make fixtures`.
+fn fixtures() -> Vec<Vec<u8>> {
+    let directory = Path::new(env!("CARGO_MANIFEST_DIR")).join("bench/fixtures");
+    let mut paths: Vec<PathBuf> = fs::read_dir(&directory)
+        .expect("no bench/fixtures, run `make fixtures`")
+        .map(|entry| entry.unwrap().path())
+        .filter(|path| path.extension().map_or(false, |ext| ext == "dj"))
+        .collect();
+    paths.sort();
+    let fixtures: Vec<Vec<u8>> = paths.iter().map(|path| fs::read(path).unwrap()).collect();
+    (0..COPIES).flat_map(|_| fixtures.clone()).collect()
+}
+
+fn parse_many(c: &mut Criterion) {
+    let corpus = fixtures();
+    let documents: Vec<&[u8]> = corpus.iter().map(Vec::as_slice).collect();
+
+    let parallelism = std::thread::available_parallelism().map_or(1, |n| n.get());
+    let mut threads = vec![];
+    let mut n = 1;
+    while n < parallelism {
+        threads.push(n);
+        n *= 2;
+    }
+    threads.push(parallelism);
+
+    let mut group = c.benchmark_group("parse_many");
+    group.throughput(Throughput::Elements(documents.len() as u64));
+    group.sample_size(20);
+    for n in threads {
+        let pool = rayon::ThreadPoolBuilder::new()
+            .num_threads(n)
+            .build()
+            .unwrap();
+        group.bench_with_input(
+            BenchmarkId::new("threads", n),
+            &documents,
+            |b, documents| b.iter(|| pool.install(|| tree_sitter_djot::parse_many(documents))),
+        );
+    }
+    group.finish();
+}
+
+criterion_group!(benches, parse_many);
+criterion_main!(benches);
@@ -6,17 +6,27 @@
 //! ```
 //! let code = "";
 //! let mut parser = tree_sitter::Parser::new();
-//! parser.set_language(tree_sitter_djot::language()).expect("Error loading Djot grammar");
+//! parser.set_language(&tree_sitter_djot::language()).expect("Error loading Djot grammar");
 //! let tree = parser.parse(code, None).unwrap();
 //! ```
 //!
+//! With the `parallel` feature, [parse_many][] parses many documents at once on the [rayon][]
+//! thread pool.
+//!
 //! [Language]: https://docs.rs/tree-sitter/*/tree_sitter/struct.Language.html
 //! [language func]: fn.language.html
+//! [parse_many]: fn.parse_many.html
 //! [Parser]: https://docs.rs/tree-sitter/*/tree_sitter/struct.Parser.html
+//! [rayon]: https://docs.rs/rayon
 //! [tree-sitter]: https://tree-sitter.github.io/
 
 use tree_sitter::Language;
 
+#[cfg(feature = "parallel")]
+mod parallel;
+#[cfg(feature = "parallel")]
+pub use parallel::parse_many;
+
 extern "C" {
     fn tree_sitter_djot() -> Language;
 }
@@ -37,7 +47,7 @@ pub const NODE_TYPES: &'static str = include_str!("../../src/node-types.json");
 
 pub const HIGHLIGHTS_QUERY: &'static str = include_str!("../../queries/highlights.scm");
 pub const INJECTIONS_QUERY: &'static str = include_str!("../../queries/injections.scm");
-// pub const LOCALS_QUERY: &'static str = include_str!("../../queries/locals.scm");
+pub const LOCALS_QUERY: &'static str = include_str!("../../queries/locals.scm");
 // pub const TAGS_QUERY: &'static str = include_str!("../../queries/tags.scm");
 
 #[cfg(test)]
@@ -46,7 +56,7 @@ mod tests {
     fn test_can_load_grammar() {
         let mut parser = tree_sitter::Parser::new();
         parser
-            .set_language(super::language())
+            .set_language(&super::language())
             .expect("Error loading Djot language");
     }
 }
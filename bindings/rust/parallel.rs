@@ -0,0 +1,103 @@
+use std::cell::RefCell;
+
+use rayon::prelude::*;
+use tree_sitter::{Parser, Tree};
+
+thread_local! {
+    static PARSER: RefCell<Option<Parser>> = RefCell::new(None);
+}
+
+/// Parse many documents in parallel on the current [rayon][] thread pool.
+///
+/// Each thread of the pool creates a parser the first time it's used and
+/// keeps it for later calls, so parsers aren't created per document. The
+/// trees are in the order of the documents. Run it in
+/// [`ThreadPool::install`][] to choose the number of threads.
+///
+/// ```
+/// let documents: Vec<&[u8]> = vec![b"# Heading\n", b"_emphasis_\n"];
+/// let trees = tree_sitter_djot::parse_many(&documents);
+/// assert_eq!(trees[0].root_node().kind(), "document");
+/// ```
+///
+/// [rayon]: https://docs.rs/rayon
+/// [`ThreadPool::install`]: https://docs.rs/rayon/*/rayon/struct.ThreadPool.html#method.install
+pub fn parse_many(documents: &[&[u8]]) -> Vec<Tree> {
+    documents
+        .par_iter()
+        .map(|document| parse(document))
+        .collect()
+}
+
+fn parse(document: &[u8]) -> Tree {
+    PARSER.with(|parser| {
+        let mut parser = parser.borrow_mut();
+        let parser = parser.get_or_insert_with(|| {
+            let mut parser = Parser::new();
+            parser
+                .set_language(&crate::language())
+                .expect("Error loading Djot grammar");
+            parser
+        });
+        // Parsing only fails without a language, a timeout or a cancellation
+        // flag, and this parser has a language and neither of the others.
+        parser.parse(document, None).unwrap()
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use tree_sitter::{Parser, Tree};
+
+    const DOCUMENTS: [&[u8]; 8] = [
+        b"# Heading\n\nSome _emphasis_, *strong* and `verbatim` text.\n",
+        b"- a\n- b\n\n1. c\n2. d\n",
+        b"> quote\n> [link](url)\n",
+        b"| a | b |\n|---|---|\n| c | d |\n",
+        b"```rust\nfn main() {}\n```\n",
+        b"---\nkey: value\n",
+        b"{#id .class}\n::: note\ntext\n:::\n",
+        b"",
+    ];
+
+    /// The kind and byte range of every node of a tree, in pre-order.
+    fn nodes(tree: &Tree) -> Vec<(&'static str, usize, usize)> {
+        let mut nodes = vec![];
+        let mut cursor = tree.walk();
+        loop {
+            let node = cursor.node();
+            nodes.push((node.kind(), node.start_byte(), node.end_byte()));
+            if cursor.goto_first_child() {
+                continue;
+            }
+            while !cursor.goto_next_sibling() {
+                if !cursor.goto_parent() {
+                    return nodes;
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_parse_many_matches_parse() {
+        let documents: Vec<&[u8]> = (0..16).flat_map(|_| DOCUMENTS).collect();
+        let mut parser = Parser::new();
+        parser.set_language(&crate::language()).unwrap();
+        let expected: Vec<_> = documents
+            .iter()
+            .map(|document| nodes(&parser.parse(document, None).unwrap()))
+            .collect();
+
+        let pool = rayon::ThreadPoolBuilder::new()
+            .num_threads(4)
+            .build()
+            .unwrap();
+        // The second round parses with the parsers the first one left on
+        // the pool's threads.
+        for _ in 0..2 {
+            let trees = pool.install(|| super::parse_many(&documents));
+            let actual: Vec<_> = trees.iter().map(nodes).collect();
+            assert_eq!(actual, expected);
+        }
+    }
+}
@@ -30,19 +30,19 @@ module.exports = grammar({
       seq(
         $.frontmatter_marker,
         $._whitespace,
-        optional($.language),
+        optional(field("language", $.language)),
         $._newline,
-        $.frontmatter_content,
+        field("content", $.frontmatter_content),
         $.frontmatter_marker,
         $._newline,
       ),
-    frontmatter_content: ($) => repeat1($._line),
+    frontmatter_content: ($) => repeat1($._frontmatter_content),
 
     // A section is only valid on the top level, or nested inside other sections.
     // Otherwise standalone headings are used (inside divs for example).
     _block_with_section: ($) => choice($.section, $._block_element, $._newline),
     _block_with_heading: ($) =>
-      choice($._heading, $._block_element, $._newline),
+      choice($.heading, $._block_element, $._newline),
 
     _block_element: ($) =>
       choice(
@@ -63,137 +63,73 @@ module.exports = grammar({
     // Section should end by a new header with the same or fewer amount of '#'.
     section: ($) =>
       seq(
-        $._heading,
-        alias(repeat($._block_with_section), $.section_content),
+        field("heading", $.heading),
+        field(
+          "content",
+          alias(repeat($._block_with_section), $.section_content),
+        ),
         $._block_close,
       ),
 
-    // Headings can't be mixed, this verbose description (together with the external scanner)
-    // ensures that they're not.
-    _heading: ($) =>
-      choice(
-        $.heading1,
-        $.heading2,
-        $.heading3,
-        $.heading4,
-        $.heading5,
-        $.heading6,
-      ),
-    heading1: ($) =>
-      seq(
-        alias($._heading1_begin, $.marker),
-        alias($._heading1_content, $.content),
-        $._block_close,
-        optional($._eof_or_blankline),
-      ),
-    _heading1_content: ($) =>
-      seq(
-        $._inline_line,
-        repeat(seq(alias($._heading1_continuation, $.marker), $._inline_line)),
-      ),
-    heading2: ($) =>
-      seq(
-        alias($._heading2_begin, $.marker),
-        alias($._heading2_content, $.content),
-        $._block_close,
-        optional($._eof_or_blankline),
-      ),
-    _heading2_content: ($) =>
-      seq(
-        $._inline_line,
-        repeat(seq(alias($._heading2_continuation, $.marker), $._inline_line)),
-      ),
-    heading3: ($) =>
-      seq(
-        alias($._heading3_begin, $.marker),
-        alias($._heading5_content, $.content),
-        $._block_close,
-        optional($._eof_or_blankline),
-      ),
-    _heading3_content: ($) =>
-      seq(
-        $._inline_line,
-        repeat(seq(alias($._heading3_continuation, $.marker), $._inline_line)),
-      ),
-    heading4: ($) =>
-      seq(
-        alias($._heading4_begin, $.marker),
-        alias($._heading5_content, $.content),
-        $._block_close,
-        optional($._eof_or_blankline),
-      ),
-    _heading4_content: ($) =>
-      seq(
-        $._inline_line,
-        repeat(seq(alias($._heading4_continuation, $.marker), $._inline_line)),
-      ),
-    heading5: ($) =>
+    // Headings can't be mixed, the external scanner only continues a heading
+    // with a marker of the same level and closes it before any other.
+    // The level is the number of `#` in the marker.
+    heading: ($) =>
       seq(
-        alias($._heading5_begin, $.marker),
-        alias($._heading5_content, $.content),
+        field("marker", alias($._heading_begin, $.marker)),
+        field("content", alias($._heading_content, $.content)),
         $._block_close,
         optional($._eof_or_blankline),
       ),
-    _heading5_content: ($) =>
+    _heading_content: ($) =>
       seq(
         $._inline_line,
-        repeat(seq(alias($._heading5_continuation, $.marker), $._inline_line)),
-      ),
-    heading6: ($) =>
-      seq(
-        alias($._heading6_begin, $.marker),
-        alias($._heading6_content, $.content),
-        $._block_close,
-        optional($._eof_or_blankline),
-      ),
-    _heading6_content: ($) =>
-      seq(
-        $._inline_line,
-        repeat(seq(alias($._heading6_continuation, $.marker), $._inline_line)),
+        repeat(seq(alias($._heading_continuation, $.marker), $._inline_line)),
       ),
 
-    // Djot has a crazy number of different list types,
-    // that we need to keep separate from each other.
+    // Djot has a crazy number of different list types, that we need to keep
+    // separate from each other. They share a single rule: the external scanner
+    // closes a list before a marker of a different type, and the type of a
+    // list is given by the marker of its items.
     list: ($) =>
       prec.left(
         choice(
-          $._list_dash,
-          $._list_plus,
-          $._list_star,
-          $._list_task,
-          $._list_definition,
-          $._list_decimal_period,
-          $._list_decimal_paren,
-          $._list_decimal_parens,
-          $._list_lower_alpha_period,
-          $._list_lower_alpha_paren,
-          $._list_lower_alpha_parens,
-          $._list_upper_alpha_period,
-          $._list_upper_alpha_paren,
-          $._list_upper_alpha_parens,
-          $._list_lower_roman_period,
-          $._list_lower_roman_paren,
-          $._list_lower_roman_parens,
-          $._list_upper_roman_period,
-          $._list_upper_roman_paren,
-          $._list_upper_roman_parens,
+          seq(repeat1($.list_item), $._block_close),
+          seq(
+            repeat1(alias($._list_item_definition, $.list_item)),
+            $._block_close,
+          ),
         ),
       ),
-    _list_dash: ($) =>
-      seq(repeat1(alias($._list_item_dash, $.list_item)), $._block_close),
-    _list_item_dash: ($) => seq($.list_marker_dash, $.list_item_content),
-
-    _list_plus: ($) =>
-      seq(repeat1(alias($._list_item_plus, $.list_item)), $._block_close),
-    _list_item_plus: ($) => seq($.list_marker_plus, $.list_item_content),
-
-    _list_star: ($) =>
-      seq(repeat1(alias($._list_item_star, $.list_item)), $._block_close),
-    _list_item_star: ($) => seq($.list_marker_star, $.list_item_content),
+    list_item: ($) =>
+      seq(
+        field(
+          "marker",
+          choice(
+            $.list_marker_dash,
+            $.list_marker_plus,
+            $.list_marker_star,
+            $.list_marker_task,
+            $.list_marker_decimal_period,
+            $.list_marker_decimal_paren,
+            $.list_marker_decimal_parens,
+            $.list_marker_lower_alpha_period,
+            $.list_marker_lower_alpha_paren,
+            $.list_marker_lower_alpha_parens,
+            $.list_marker_upper_alpha_period,
+            $.list_marker_upper_alpha_paren,
+            $.list_marker_upper_alpha_parens,
+            $.list_marker_lower_roman_period,
+            $.list_marker_lower_roman_paren,
+            $.list_marker_lower_roman_parens,
+            $.list_marker_upper_roman_period,
+            $.list_marker_upper_roman_paren,
+            $.list_marker_upper_roman_parens,
+          ),
+        ),
+        field("content", $.list_item_content),
+      ),
 
-    _list_task: ($) =>
-      seq(repeat1(alias($._list_item_task, $.list_item)), $._block_close),
-    _list_item_task: ($) => seq($.list_marker_task, $.list_item_content),
     list_marker_task: ($) =>
       seq(
         $._list_marker_task_begin,
@@ -203,127 +139,18 @@ module.exports = grammar({
     checked: (_) => seq("[", choice("x", "X"), "]"),
     unchecked: (_) => seq("[", " ", "]"),
 
-    _list_definition: ($) =>
-      seq(repeat1(alias($._list_item_definition, $.list_item)), $._block_close),
     _list_item_definition: ($) =>
       seq(
-        $.list_marker_definition,
-        alias($._paragraph_content, $.term),
+        field("marker", $.list_marker_definition),
+        field("term", alias($._paragraph_content, $.term)),
         choice($._eof_or_blankline, $._close_paragraph),
-        alias(optional(repeat($._block_with_heading)), $.definition),
+        field(
+          "definition",
+          alias(optional(repeat($._block_with_heading)), $.definition),
+        ),
         $._list_item_end,
       ),
 
-    _list_decimal_period: ($) =>
-      seq(
-        repeat1(alias($._list_item_decimal_period, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_decimal_period: ($) =>
-      seq($.list_marker_decimal_period, $.list_item_content),
-    _list_decimal_paren: ($) =>
-      seq(
-        repeat1(alias($._list_item_decimal_paren, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_decimal_paren: ($) =>
-      seq($.list_marker_decimal_paren, $.list_item_content),
-    _list_decimal_parens: ($) =>
-      seq(
-        repeat1(alias($._list_item_decimal_parens, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_decimal_parens: ($) =>
-      seq($.list_marker_decimal_parens, $.list_item_content),
-
-    _list_lower_alpha_period: ($) =>
-      seq(
-        repeat1(alias($._list_item_lower_alpha_period, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_lower_alpha_period: ($) =>
-      seq($.list_marker_lower_alpha_period, $.list_item_content),
-    _list_lower_alpha_paren: ($) =>
-      seq(
-        repeat1(alias($._list_item_lower_alpha_paren, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_lower_alpha_paren: ($) =>
-      seq($.list_marker_lower_alpha_paren, $.list_item_content),
-    _list_lower_alpha_parens: ($) =>
-      seq(
-        repeat1(alias($._list_item_lower_alpha_parens, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_lower_alpha_parens: ($) =>
-      seq($.list_marker_lower_alpha_parens, $.list_item_content),
-
-    _list_upper_alpha_period: ($) =>
-      seq(
-        repeat1(alias($._list_item_upper_alpha_period, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_upper_alpha_period: ($) =>
-      seq($.list_marker_upper_alpha_period, $.list_item_content),
-    _list_upper_alpha_paren: ($) =>
-      seq(
-        repeat1(alias($._list_item_upper_alpha_paren, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_upper_alpha_paren: ($) =>
-      seq($.list_marker_upper_alpha_paren, $.list_item_content),
-    _list_upper_alpha_parens: ($) =>
-      seq(
-        repeat1(alias($._list_item_upper_alpha_parens, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_upper_alpha_parens: ($) =>
-      seq($.list_marker_upper_alpha_parens, $.list_item_content),
-
-    _list_lower_roman_period: ($) =>
-      seq(
-        repeat1(alias($._list_item_lower_roman_period, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_lower_roman_period: ($) =>
-      seq($.list_marker_lower_roman_period, $.list_item_content),
-    _list_lower_roman_paren: ($) =>
-      seq(
-        repeat1(alias($._list_item_lower_roman_paren, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_lower_roman_paren: ($) =>
-      seq($.list_marker_lower_roman_paren, $.list_item_content),
-    _list_lower_roman_parens: ($) =>
-      seq(
-        repeat1(alias($._list_item_lower_roman_parens, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_lower_roman_parens: ($) =>
-      seq($.list_marker_lower_roman_parens, $.list_item_content),
-
-    _list_upper_roman_period: ($) =>
-      seq(
-        repeat1(alias($._list_item_upper_roman_period, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_upper_roman_period: ($) =>
-      seq($.list_marker_upper_roman_period, $.list_item_content),
-    _list_upper_roman_paren: ($) =>
-      seq(
-        repeat1(alias($._list_item_upper_roman_paren, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_upper_roman_paren: ($) =>
-      seq($.list_marker_upper_roman_paren, $.list_item_content),
-    _list_upper_roman_parens: ($) =>
-      seq(
-        repeat1(alias($._list_item_upper_roman_parens, $.list_item)),
-        $._block_close,
-      ),
-    _list_item_upper_roman_parens: ($) =>
-      seq($.list_marker_upper_roman_parens, $.list_item_content),
-
     list_item_content: ($) =>
       seq(repeat1($._block_with_heading), $._list_item_end),
 
@@ -365,20 +192,23 @@ module.exports = grammar({
       ),
     table_cell_alignment: (_) => token.immediate(prec(100, /:?-+:?/)),
     table_cell: ($) =>
-      prec.left(repeat1($._inline_element_with_whitespace_without_newline)),
+      choice(
+        $._table_cell_text,
+        prec.left(repeat1($._inline_element_with_whitespace_without_newline)),
+      ),
     table_caption: ($) =>
       seq(
-        alias($._table_caption_begin, $.marker),
-        alias(repeat1($._inline_line), $.content),
+        field("marker", alias($._table_caption_begin, $.marker)),
+        field("content", alias(repeat1($._inline_line), $.content)),
         choice($._table_caption_end, "\0"),
       ),
 
     footnote: ($) =>
       seq(
         alias($._footnote_begin, $.footnote_marker_begin),
-        $.reference_label,
+        field("label", $.reference_label),
         alias("]:", $.footnote_marker_end),
-        $.footnote_content,
+        field("content", $.footnote_content),
         $._footnote_end,
       ),
     footnote_content: ($) => repeat1($._block_with_heading),
@@ -387,21 +217,24 @@ module.exports = grammar({
       seq(
         $.div_marker_begin,
         $._newline,
-        alias(repeat($._block_with_heading), $.content),
+        field("content", alias(repeat($._block_with_heading), $.content)),
         $._block_close,
         optional(alias($._div_end, $.div_marker_end)),
       ),
     div_marker_begin: ($) =>
-      seq($._div_begin, optional(seq($._whitespace1, $.class_name))),
+      seq(
+        $._div_begin,
+        optional(seq($._whitespace1, field("class", $.class_name))),
+      ),
     class_name: ($) => $._id,
 
     code_block: ($) =>
       seq(
         alias($._code_block_begin, $.code_block_marker_begin),
         $._whitespace,
-        optional($.language),
+        optional(field("language", $.language)),
         $._newline,
-        optional($.code),
+        optional(field("content", $.code)),
         $._block_close,
         optional(alias($._code_block_end, $.code_block_marker_end)),
       ),
@@ -411,16 +244,18 @@ module.exports = grammar({
         $._whitespace,
         $.raw_block_info,
         $._newline,
-        optional(alias($.code, $.content)),
+        optional(field("content", alias($.code, $.content))),
         $._block_close,
         optional(alias($._code_block_end, $.raw_block_marker_end)),
       ),
-    raw_block_info: ($) => seq(alias("=", $.language_marker), $.language),
+    raw_block_info: ($) =>
+      seq(alias("=", $.language_marker), field("language", $.language)),
 
     language: (_) => /[^\n\t \{\}=]+/,
     code: ($) =>
-      prec.left(repeat1(seq(optional($._block_quote_prefix), $._line))),
-    _line: ($) => seq(/[^\n]*/, $._newline),
+      prec.left(
+        repeat1(seq(optional($._block_quote_prefix), $._code_block_content)),
+      ),
 
     thematic_break: ($) =>
       choice($._thematic_break_dash, $._thematic_break_star),
@@ -428,12 +263,12 @@ module.exports = grammar({
     block_quote: ($) =>
       seq(
         alias($._block_quote_begin, $.block_quote_marker),
-        alias($._block_quote_content, $.content),
+        field("content", alias($._block_quote_content, $.content)),
         $._block_close,
       ),
     _block_quote_content: ($) =>
       seq(
-        choice($._heading, $._block_element),
+        choice($.heading, $._block_element),
         repeat(seq($._block_quote_prefix, optional($._block_element))),
       ),
     _block_quote_prefix: ($) =>
@@ -444,11 +279,11 @@ module.exports = grammar({
     link_reference_definition: ($) =>
       seq(
         "[",
-        alias($._inline, $.link_label),
+        field("label", alias($._inline, $.link_label)),
         "]",
         ":",
         $._whitespace1,
-        $.link_destination,
+        field("destination", $.link_destination),
         $._one_or_two_newlines,
       ),
     link_destination: (_) => /\S+/,
@@ -473,7 +308,7 @@ module.exports = grammar({
       ),
     class: ($) => seq(".", alias($.class_name, "class")),
     identifier: (_) => token(seq("#", token.immediate(/[^\s\}]+/))),
-    key_value: ($) => seq($.key, "=", $.value),
+    key_value: ($) => seq(field("key", $.key), "=", field("value", $.value)),
     key: ($) => $._id,
     value: (_) => choice(seq('"', /[^"\n]+/, '"'), /\w+/),
 
@@ -544,6 +379,7 @@ module.exports = grammar({
               $.comment,
               $._todo_highlights,
               $._symbol_fallback,
+              $._unclosed_symbol,
               $._text,
             ),
             optional($.inline_attribute),
@@ -585,7 +421,7 @@ module.exports = grammar({
     emphasis: ($) =>
       seq(
         $.emphasis_begin,
-        alias($._inline_no_surrounding_spaces, $.content),
+        field("content", alias($._inline_no_surrounding_spaces, $.content)),
         $.emphasis_end,
       ),
 
@@ -597,28 +433,39 @@ module.exports = grammar({
     strong: ($) =>
       seq(
         $.strong_begin,
-        alias($._inline_no_surrounding_spaces, $.content),
+        field("content", alias($._inline_no_surrounding_spaces, $.content)),
         $.strong_end,
       ),
     strong_begin: (_) => choice(seq("{*", repeat(" ")), "*"),
     strong_end: (_) => choice(token(seq(repeat(" "), "*}")), "*"),
 
-    highlighted: ($) => seq("{=", alias($._inline, $.content), "=}"),
-    insert: ($) => seq("{+", alias($._inline, $.content), "+}"),
-    delete: ($) => seq("{-", alias($._inline, $.content), "-}"),
+    highlighted: ($) =>
+      seq("{=", field("content", alias($._inline, $.content)), "=}"),
+    insert: ($) =>
+      seq("{+", field("content", alias($._inline, $.content)), "+}"),
+    delete: ($) =>
+      seq("{-", field("content", alias($._inline, $.content)), "-}"),
     symbol: (_) => token(seq(":", /[^:\s]+/, ":")),
 
     // The syntax description isn't clear about if non-bracket can contain surrounding spaces?
     // The live playground suggests that yes they can.
     superscript: ($) =>
-      seq(choice("{^", "^"), alias($._inline, $.content), choice("^}", "^")),
+      seq(
+        choice("{^", "^"),
+        field("content", alias($._inline, $.content)),
+        choice("^}", "^"),
+      ),
     subscript: ($) =>
-      seq(choice("{~", "~"), alias($._inline, $.content), choice("~}", "~")),
+      seq(
+        choice("{~", "~"),
+        field("content", alias($._inline, $.content)),
+        choice("~}", "~"),
+      ),
 
     footnote_reference: ($) =>
       seq(
         alias("[^", $.footnote_marker_begin),
-        $.reference_label,
+        field("label", $.reference_label),
         alias("]", $.footnote_marker_end),
       ),
 
@@ -634,21 +481,38 @@ module.exports = grammar({
     full_reference_image: ($) => seq($._image_description, $._link_label),
     collapsed_reference_image: ($) =>
       seq($._image_description, token.immediate("[]")),
-    inline_image: ($) => seq($._image_description, $.inline_link_destination),
+    inline_image: ($) =>
+      seq(
+        $._image_description,
+        field("destination", $.inline_link_destination),
+      ),
 
     _image_description: ($) =>
-      seq("![", optional(alias($._inline, $.image_description)), "]"),
+      seq(
+        "![",
+        optional(field("description", alias($._inline, $.image_description))),
+        "]",
+      ),
 
     _link: ($) =>
       choice($.full_reference_link, $.collapsed_reference_link, $.inline_link),
-    full_reference_link: ($) => seq($.link_text, $._link_label),
-    collapsed_reference_link: ($) => seq($.link_text, token.immediate("[]")),
-    inline_link: ($) => seq($.link_text, $.inline_link_destination),
+    full_reference_link: ($) => seq(field("text", $.link_text), $._link_label),
+    collapsed_reference_link: ($) =>
+      seq(field("text", $.link_text), token.immediate("[]")),
+    inline_link: ($) =>
+      seq(
+        field("text", $.link_text),
+        field("destination", $.inline_link_destination),
+      ),
 
     link_text: ($) => seq("[", $._inline, "]"),
 
     _link_label: ($) =>
-      seq("[", alias($._inline, $.link_label), token.immediate("]")),
+      seq(
+        "[",
+        field("label", alias($._inline, $.link_label)),
+        token.immediate("]"),
+      ),
     inline_link_destination: (_) => seq("(", /[^\n\)]+/, ")"),
 
     inline_attribute: ($) =>
@@ -674,7 +538,8 @@ module.exports = grammar({
     // if it only contains a comment.
     comment: ($) => seq("{", $._comment_with_newline, "}"),
 
-    span: ($) => seq("[", $._inline, "]", $.inline_attribute),
+    span: ($) =>
+      seq("[", $._inline, "]", field("attributes", $.inline_attribute)),
 
     _comment_with_newline: ($) =>
       seq(
@@ -682,38 +547,52 @@ module.exports = grammar({
         // With a whitespace here there's weirdly enough no conflict with
         // `_comment_no_newline` despite only a single choice difference.
         $._whitespace,
-        alias(
-          repeat(choice($.backslash_escape, /[^%\n]/, $._newline)),
-          $.content,
+        // Text between escapes and newlines is a single token, a `\` that
+        // doesn't escape anything is text of its own.
+        field(
+          "content",
+          alias(
+            repeat(
+              choice($.backslash_escape, /[^%\n\\]+/, /[^%\n]/, $._newline),
+            ),
+            $.content,
+          ),
         ),
         "%",
       ),
     _comment_no_newline: ($) =>
       seq(
         "%",
-        alias(repeat(choice($.backslash_escape, /[^%\n]/)), $.content),
+        field(
+          "content",
+          alias(
+            repeat(choice($.backslash_escape, /[^%\n\\]+/, /[^%\n]/)),
+            $.content,
+          ),
+        ),
         "%",
       ),
 
     raw_inline: ($) =>
       seq(
         alias($._verbatim_begin, $.raw_inline_marker_begin),
-        alias($._verbatim_content, $.content),
+        field("content", alias(repeat1($._verbatim_content), $.content)),
         alias($._verbatim_end, $.raw_inline_marker_end),
-        $.raw_inline_attribute,
+        field("attributes", $.raw_inline_attribute),
       ),
-    raw_inline_attribute: ($) => seq(token.immediate("{="), $.language, "}"),
+    raw_inline_attribute: ($) =>
+      seq(token.immediate("{="), field("language", $.language), "}"),
     math: ($) =>
       seq(
         alias("$", $.math_marker),
         alias($._verbatim_begin, $.math_marker_begin),
-        alias($._verbatim_content, $.content),
+        field("content", alias(repeat1($._verbatim_content), $.content)),
         alias($._verbatim_end, $.math_marker_end),
       ),
     verbatim: ($) =>
       seq(
         alias($._verbatim_begin, $.verbatim_marker_begin),
-        alias($._verbatim_content, $.content),
+        field("content", alias(repeat1($._verbatim_content), $.content)),
         alias($._verbatim_end, $.verbatim_marker_end),
       ),
 
@@ -749,8 +628,12 @@ module.exports = grammar({
           "$",
         ),
       ),
-    // It's a bit faster with repeat1 here.
-    _text: (_) => repeat1(/\S/),
+    // Runs of characters that can't start any inline markup or a `todo`,
+    // `note` or `fixme` keyword are lexed as a single token, anything else
+    // one character at a time so markup may start right after it. It's a
+    // bit faster with repeat1 here.
+    _text: (_) =>
+      repeat1(choice(/[^\s!"#$%'()*+\-.:<=>\[\\\]^_`{|}~FINTWX]+/, /\S/)),
   },
 
   externals: ($) => [
@@ -783,6 +666,8 @@ module.exports = grammar({
     // Detects a frontmatter delimiters: `---`
     // Handled externally to resolve conflicts with list markers and thematic breaks.
     $.frontmatter_marker,
+    // Lines of frontmatter up to the closing marker, in a few large tokens.
+    $._frontmatter_content,
 
     // Blocks.
     // The external scanner keeps a stack of blocks for context in order to
@@ -790,26 +675,18 @@ module.exports = grammar({
 
     // Headings open and close sections, but they're not exposed to `grammar.js`
     // but is used by the external scanner internally.
-    $._heading1_begin,
+    $._heading_begin,
     // Heading continuation can continue a heading, but only if
     // they match the number of `#` (or there's no `#`).
-    $._heading1_continuation,
-    $._heading2_begin,
-    $._heading2_continuation,
-    $._heading3_begin,
-    $._heading3_continuation,
-    $._heading4_begin,
-    $._heading4_continuation,
-    $._heading5_begin,
-    $._heading5_continuation,
-    $._heading6_begin,
-    $._heading6_continuation,
+    $._heading_continuation,
     // Matches div markers with varying number of `:`.
     $._div_begin,
     $._div_end,
     // Matches code block markers with varying number of `.
     $._code_block_begin,
     $._code_block_end,
+    // Lines of code up to the closing marker, in a few large tokens.
+    $._code_block_content,
     // There are lots of lists in Djot that shouldn't be mixed.
     // Parsing a list marker opens or closes lists depending on the marker type.
     $.list_marker_dash,
@@ -857,6 +734,8 @@ module.exports = grammar({
     // Table captions have significant whitespace.
     $._table_caption_begin,
     $._table_caption_end,
+    // A table cell without markup, up to the next `|`.
+    $._table_cell_text,
 
     // Inline elements.
 
@@ -865,6 +744,10 @@ module.exports = grammar({
     $._verbatim_begin,
     $._verbatim_end,
     $._verbatim_content,
+    // A `[`, `![`, `{` or `<` without a closer in the rest of the paragraph,
+    // that can't start markup and doesn't need the `_symbol_fallback`
+    // conflicts to be resolved.
+    $._unclosed_symbol,
 
     // Never valid and is only used to signal an internal scanner error.
     $._error,
@@ -30,17 +30,35 @@
 (full_reference_image
   (link_label) @nospell)
 
-(heading1) @markup.heading.1
+((heading
+  .
+  (marker) @_marker) @markup.heading.1
+  (#match? @_marker "^\\s*# "))
 
-(heading2) @markup.heading.2
+((heading
+  .
+  (marker) @_marker) @markup.heading.2
+  (#match? @_marker "^\\s*## "))
 
-(heading3) @markup.heading.3
+((heading
+  .
+  (marker) @_marker) @markup.heading.3
+  (#match? @_marker "^\\s*### "))
 
-(heading4) @markup.heading.4
+((heading
+  .
+  (marker) @_marker) @markup.heading.4
+  (#match? @_marker "^\\s*#### "))
 
-(heading5) @markup.heading.5
+((heading
+  .
+  (marker) @_marker) @markup.heading.5
+  (#match? @_marker "^\\s*##### "))
 
-(heading6) @markup.heading.6
+((heading
+  .
+  (marker) @_marker) @markup.heading.6
+  (#match? @_marker "^\\s*###### "))
 
 (thematic_break) @string.special
 
@@ -1,10 +1,58 @@
-from os.path import isdir, join
+from os import environ
+from os.path import isdir, isfile, join
 from platform import system
+from subprocess import CalledProcessError, check_output
 
 from setuptools import Extension, find_packages, setup
 from setuptools.command.build import build
+from setuptools.command.build_ext import build_ext
 from wheel.bdist_wheel import bdist_wheel
 
+sources = [
+    "bindings/python/tree_sitter_djot/binding.c",
+    "src/parser.c",
+    "src/scanner.c",
+]
+include_dirs = ["src"]
+define_macros = [("Py_LIMITED_API", "0x03080000"), ("PY_SSIZE_T_CLEAN", None)]
+libraries = []
+library_dirs = []
+extra_objects = []
+
+
+def pkg_config(*args):
+    try:
+        return check_output(["pkg-config", *args, "tree-sitter"], text=True)
+    except (OSError, CalledProcessError):
+        return None
+
+
+# `parse_table` needs the tree-sitter runtime. It's compiled in like the
+# scanner when TREE_SITTER_LIB points to the `lib` directory of a tree-sitter
+# checkout, or else linked from the library that pkg-config finds, the
+# static one if there is one. Without either the build stops, see BuildExt.
+# Windows has neither mmap nor pthreads and builds only `language`.
+TREE_SITTER_LIB = environ.get("TREE_SITTER_LIB")
+NO_RUNTIME = False
+if system() == "Windows":
+    pass
+elif TREE_SITTER_LIB:
+    sources.append(join(TREE_SITTER_LIB, "src", "lib.c"))
+    include_dirs += [join(TREE_SITTER_LIB, "include"), join(TREE_SITTER_LIB, "src")]
+    # The runtime uses POSIX functions, which -std=c11 hides.
+    define_macros += [("_DEFAULT_SOURCE", None), ("TREE_SITTER_DJOT_TABLE", None)]
+elif pkg_config("--exists") is not None:
+    include_dirs += [flag[2:] for flag in pkg_config("--cflags-only-I").split()]
+    libdir = pkg_config("--variable=libdir").strip()
+    if isfile(join(libdir, "libtree-sitter.a")):
+        extra_objects.append(join(libdir, "libtree-sitter.a"))
+    else:
+        libraries.append("tree-sitter")
+        library_dirs.append(libdir)
+    define_macros.append(("TREE_SITTER_DJOT_TABLE", None))
+else:
+    NO_RUNTIME = True
+
 
 class Build(build):
     def run(self):
@@ -14,6 +62,17 @@ class Build(build):
         super().run()
 
 
+class BuildExt(build_ext):
+    def run(self):
+        if NO_RUNTIME:
+            raise SystemExit(
+                "tree-sitter-djot: no tree-sitter runtime for parse_table. "
+                "Set TREE_SITTER_LIB to the lib directory of a tree-sitter "
+                "checkout, or install the library where pkg-config finds it."
+            )
+        super().run()
+
+
 class BdistWheel(bdist_wheel):
     def get_tag(self):
         python, abi, platform = super().get_tag()
@@ -33,24 +92,21 @@ setup(
     ext_modules=[
         Extension(
             name="_binding",
-            sources=[
-                "bindings/python/tree_sitter_djot/binding.c",
-                "src/parser.c",
-                # NOTE: if your language uses an external scanner, add it here.
-            ],
+            sources=sources,
             extra_compile_args=(
                 ["-std=c11"] if system() != 'Windows' else []
             ),
-            define_macros=[
-                ("Py_LIMITED_API", "0x03080000"),
-                ("PY_SSIZE_T_CLEAN", None)
-            ],
-            include_dirs=["src"],
+            define_macros=define_macros,
+            include_dirs=include_dirs,
+            libraries=libraries,
+            library_dirs=library_dirs,
+            extra_objects=extra_objects,
             py_limited_api=True,
         )
     ],
     cmdclass={
         "build": Build,
+        "build_ext": BuildExt,
         "bdist_wheel": BdistWheel
     },
     zip_safe=False
@@ -20,23 +20,15 @@ typedef enum {
   NEWLINE_INLINE,
 
   FRONTMATTER_MARKER,
+  FRONTMATTER_CONTENT,
 
-  HEADING1_BEGIN,
-  HEADING1_CONTINUATION,
-  HEADING2_BEGIN,
-  HEADING2_CONTINUATION,
-  HEADING3_BEGIN,
-  HEADING3_CONTINUATION,
-  HEADING4_BEGIN,
-  HEADING4_CONTINUATION,
-  HEADING5_BEGIN,
-  HEADING5_CONTINUATION,
-  HEADING6_BEGIN,
-  HEADING6_CONTINUATION,
+  HEADING_BEGIN,
+  HEADING_CONTINUATION,
   DIV_BEGIN,
   DIV_END,
   CODE_BLOCK_BEGIN,
   CODE_BLOCK_END,
+  CODE_BLOCK_CONTENT,
   LIST_MARKER_DASH,
   LIST_MARKER_STAR,
   LIST_MARKER_PLUS,
@@ -67,10 +59,12 @@ typedef enum {
   FOOTNOTE_END,
   TABLE_CAPTION_BEGIN,
   TABLE_CAPTION_END,
+  TABLE_CELL_TEXT,
 
   VERBATIM_BEGIN,
   VERBATIM_END,
   VERBATIM_CONTENT,
+  UNCLOSED_SYMBOL,
 
   ERROR,
 } TokenType;
@@ -117,6 +111,9 @@ typedef enum {
   UPPER_ROMAN,
 } OrderedListType;
 
+// Marks a missing block in the block indices.
+#define NO_BLOCK UINT32_MAX
+
 typedef struct {
   BlockType type;
   // Level can be either indentation or number of opening/ending symbols,
@@ -127,7 +124,24 @@ typedef struct {
 typedef struct {
   // Open blocks is a stack of the blocks that haven't been closed.
   // Used to match closing markers or for implicitly closing blocks.
-  Array(Block *) * open_blocks;
+  //
+  // Blocks are stored by value and the capacity is kept between
+  // `deserialize` calls, so pushing, popping and restoring the stack
+  // doesn't allocate once the stack has grown to the document's depth.
+  // Note that pushing may reallocate, which invalidates `Block` pointers.
+  Array(Block) open_blocks;
+
+  // Indices into `open_blocks` of the top most block of a kind,
+  // so we don't have to walk the stack on every scan.
+  // Maintained by `push_block` and `pop_block`, but not reset with the stack:
+  // an entry is only valid if it points to an open block of the indexed kind,
+  // see `indexed_block`.
+  uint32_t top_list;
+  uint32_t top_block_quote;
+  // Indexed by the block level, which for block quotes is the number of `>`
+  // and for divs the number of `:`.
+  uint32_t top_block_quote_of_level[UINT8_MAX + 1];
+  uint32_t top_div_of_level[UINT8_MAX + 1];
 
   // How many BLOCK_CLOSE we should output right now?
   uint8_t blocks_to_close;
@@ -167,10 +181,6 @@ typedef struct {
   //    2. BLOCK_CLOSE (close the open list)
   //    3. Open new list
   //       Push block type and return marker
-  //
-  // Block quote
-  // In `end_paragraph_in_block_quote` we scan all markers on a line
-  // to compare levels. We should hopefully be able to reuse this information?
 
   // The number of ` we are currently matching, or 0 when not inside.
   uint8_t verbatim_tick_count;
@@ -178,12 +188,32 @@ typedef struct {
   // What's our current block quote level?
   uint8_t block_quote_level;
 
-  // Currently consumed whitespace. Resets on every token.
+  // Set when the last token ended at the start of an empty line,
+  // right before its `\n`. Tracked so we know when a newline is the
+  // first character of a line without calling `get_column`, which has
+  // to rescan the line from its start.
+  //
+  // This is enough as the grammar has no extras that match `\n`,
+  // so every newline is consumed by an external token that updates
+  // the flag, and any token that doesn't start at the `\n` clears it.
+  bool at_empty_line;
+
+  // Set by a TABLE_CELL_TEXT token, after it has checked that the line
+  // ends like a table row, so the next cells of the row don't check again.
+  //
+  // Any other external token clears it. A row ends with a NEWLINE token,
+  // so the flag never carries over to the next line.
+  bool in_table_row;
+
+  // Currently consumed whitespace. Resets on every token,
+  // so it's not serialized.
   uint8_t whitespace;
 } Scanner;
 
 static TokenType scan_list_marker_token(Scanner *s, TSLexer *lexer);
 static TokenType scan_unordered_list_marker_token(Scanner *s, TSLexer *lexer);
+static bool scan_block_quote_marker(Scanner *s, TSLexer *lexer,
+                                    bool *ending_newline);
 
 #ifdef DEBUG
 static char *block_type_s(BlockType t);
@@ -298,20 +328,121 @@ static uint8_t consume_whitespace(TSLexer *lexer) {
   return indent;
 }
 
-static Block *create_block(BlockType type, uint8_t level) {
-  Block *b = ts_malloc(sizeof(Block));
-  b->type = type;
-  b->level = level;
-  return b;
+// The index that tracks the top most block of the same kind as `type`.
+static uint32_t *top_of_kind(Scanner *s, BlockType type) {
+  if (is_list(type)) {
+    return &s->top_list;
+  } else if (type == BLOCK_QUOTE) {
+    return &s->top_block_quote;
+  } else {
+    return NULL;
+  }
+}
+
+// The index that tracks the top most block with the same type and level.
+static uint32_t *top_of_level(Scanner *s, BlockType type, uint8_t level) {
+  switch (type) {
+  case BLOCK_QUOTE:
+    return &s->top_block_quote_of_level[level];
+  case DIV:
+    return &s->top_div_of_level[level];
+  default:
+    return NULL;
+  }
+}
+
+// The block an index entry points to, or NULL if the entry is stale.
+//
+// Entries aren't cleared when the stack is reset. Pushing a block overwrites
+// the entries for its type and level, so an entry can only be stale if no
+// matching block was pushed since the reset, and then it can't point to a
+// matching block either.
+static Block *indexed_block(Scanner *s, uint32_t index, BlockType type) {
+  if (index >= s->open_blocks.size) {
+    return NULL;
+  }
+  Block *b = array_get(&s->open_blocks, index);
+  bool matches = is_list(type) ? is_list(b->type) : b->type == type;
+  return matches ? b : NULL;
 }
 
 static void push_block(Scanner *s, BlockType type, uint8_t level) {
-  array_push(s->open_blocks, create_block(type, level));
+  uint32_t index = s->open_blocks.size;
+  array_push(&s->open_blocks, ((Block){.type = type, .level = level}));
+
+  uint32_t *kind = top_of_kind(s, type);
+  if (kind) {
+    *kind = index;
+  }
+  uint32_t *same_level = top_of_level(s, type, level);
+  if (same_level) {
+    *same_level = index;
+  }
+}
+
+// Point the block indices to the top most blocks of the whole stack,
+// like pushing the blocks one by one with `push_block` would.
+//
+// This runs on every `deserialize`, so it's kept to a single pass over the
+// stack with the kind indices in locals, which is a lot faster than pushing.
+static void index_blocks(Scanner *s) {
+  const Block *blocks = s->open_blocks.contents;
+  uint32_t size = s->open_blocks.size;
+  uint32_t top_list = s->top_list;
+  uint32_t top_block_quote = s->top_block_quote;
+  for (uint32_t i = 0; i < size; ++i) {
+    switch (blocks[i].type) {
+    case BLOCK_QUOTE:
+      top_block_quote = i;
+      s->top_block_quote_of_level[blocks[i].level] = i;
+      break;
+    case DIV:
+      s->top_div_of_level[blocks[i].level] = i;
+      break;
+    default:
+      if (is_list(blocks[i].type)) {
+        top_list = i;
+      }
+      break;
+    }
+  }
+  s->top_list = top_list;
+  s->top_block_quote = top_block_quote;
+}
+
+// Blocks are popped a lot less often than the stack is restored in
+// `deserialize`, so instead of remembering the previous index entries in
+// every block we walk down the stack to find them.
+static void pop_block(Scanner *s) {
+  Block b = array_pop(&s->open_blocks);
+  uint32_t *kind = top_of_kind(s, b.type);
+  if (kind) {
+    *kind = NO_BLOCK;
+  }
+  uint32_t *same_level = top_of_level(s, b.type, b.level);
+  if (same_level) {
+    *same_level = NO_BLOCK;
+  }
+
+  for (uint32_t i = s->open_blocks.size; i-- > 0;) {
+    bool find_kind = kind && *kind == NO_BLOCK;
+    bool find_level = same_level && *same_level == NO_BLOCK;
+    if (!find_kind && !find_level) {
+      break;
+    }
+    Block *below = array_get(&s->open_blocks, i);
+    if (find_kind && indexed_block(s, i, b.type)) {
+      *kind = i;
+    }
+    if (find_level && below->type == b.type && below->level == b.level) {
+      *same_level = i;
+    }
+  }
 }
 
 static void remove_block(Scanner *s) {
-  if (s->open_blocks->size > 0) {
-    ts_free(array_pop(s->open_blocks));
+  if (s->open_blocks.size > 0) {
+    pop_block(s);
     if (s->blocks_to_close > 0) {
       --s->blocks_to_close;
     }
@@ -319,8 +450,8 @@ static void remove_block(Scanner *s) {
 }
 
 static Block *peek_block(Scanner *s) {
-  if (s->open_blocks->size > 0) {
-    return *array_back(s->open_blocks);
+  if (s->open_blocks.size > 0) {
+    return array_back(&s->open_blocks);
   } else {
     return NULL;
   }
@@ -339,7 +470,7 @@ static bool output_delayed_token(Scanner *s, TSLexer *lexer,
 
   lexer->result_symbol = s->delayed_token;
   s->delayed_token = IGNORED;
-  while (s->delayed_token_width--) {
+  for (; s->delayed_token_width > 0; --s->delayed_token_width) {
     lexer->advance(lexer, false);
   }
   lexer->mark_end(lexer);
@@ -349,35 +480,30 @@ static bool output_delayed_token(Scanner *s, TSLexer *lexer,
 // How many blocks from the top of the stack can we find a matching block?
 // If it's directly on the top, returns 1.
 // If it cannot be found, returns 0.
+// Only block quotes and divs are indexed by level.
 static size_t number_of_blocks_from_top(Scanner *s, BlockType type,
                                         uint8_t level) {
-  for (int i = s->open_blocks->size - 1; i >= 0; --i) {
-    Block *b = *array_get(s->open_blocks, i);
-    if (b->type == type && b->level == level) {
-      return s->open_blocks->size - i;
-    }
+  uint32_t *same_level = top_of_level(s, type, level);
+#ifdef DEBUG
+  assert(same_level);
+#endif
+  if (!same_level) {
+    return 0;
+  }
+  Block *b = indexed_block(s, *same_level, type);
+  if (!b || b->level != level) {
+    return 0;
   }
-  return 0;
+  return s->open_blocks.size - *same_level;
 }
 
-static Block *find_block(Scanner *s, BlockType type) {
-  for (int i = s->open_blocks->size - 1; i >= 0; --i) {
-    Block *b = *array_get(s->open_blocks, i);
-    if (b->type == type) {
-      return b;
-    }
-  }
-  return NULL;
+static Block *find_block_quote(Scanner *s) {
+  return indexed_block(s, s->top_block_quote, BLOCK_QUOTE);
 }
 
+// Any list type will do.
 static Block *find_list(Scanner *s) {
-  for (int i = s->open_blocks->size - 1; i >= 0; --i) {
-    Block *b = *array_get(s->open_blocks, i);
-    if (is_list(b->type)) {
-      return b;
-    }
-  }
-  return NULL;
+  return indexed_block(s, s->top_list, LIST_DASH);
 }
 
 // Mark that we should close `count` blocks.
@@ -385,9 +511,9 @@ static Block *find_list(Scanner *s) {
 // the other are emitted in `handle_blocks_to_close`.
 static void close_blocks(Scanner *s, TSLexer *lexer, size_t count) {
 #ifdef DEBUG
-  assert(s->open_blocks->size > 0);
+  assert(s->open_blocks.size > 0);
 #endif
-  if (s->open_blocks->size > 0) {
+  if (s->open_blocks.size > 0) {
     remove_block(s);
     s->blocks_to_close = s->blocks_to_close + count - 1;
   }
@@ -410,7 +536,7 @@ static void close_blocks_with_final_token(Scanner *s, TSLexer *lexer,
 
 // Output BLOCK_CLOSE tokens, delegated from previous iteration.
 static bool handle_blocks_to_close(Scanner *s, TSLexer *lexer) {
-  if (s->open_blocks->size == 0) {
+  if (s->open_blocks.size == 0) {
     return false;
   }
 
@@ -444,7 +570,7 @@ static bool close_different_list_if_needed(Scanner *s, TSLexer *lexer,
 // Note that this function may scan a complete list marker.
 static bool close_list_if_needed(Scanner *s, TSLexer *lexer, bool non_newline,
                                  TokenType ordered_list_marker) {
-  if (s->open_blocks->size == 0) {
+  if (s->open_blocks.size == 0) {
     return false;
   }
 
@@ -477,20 +603,8 @@ static bool close_list_if_needed(Scanner *s, TSLexer *lexer, bool non_newline,
   return false;
 }
 
-static bool scan_div_marker(Scanner *s, TSLexer *lexer, uint8_t *colons,
-                            size_t *from_top) {
-  *colons = consume_chars(lexer, ':');
-  if (*colons < 3) {
-    return false;
-  }
-  *from_top = number_of_blocks_from_top(s, DIV, *colons);
-  return true;
-}
-
-static bool is_div_marker_next(Scanner *s, TSLexer *lexer) {
-  uint8_t colons;
-  size_t from_top;
-  return scan_div_marker(s, lexer, &colons, &from_top);
+static bool is_div_marker_next(TSLexer *lexer) {
+  return consume_chars(lexer, ':') >= 3;
 }
 
 static bool parse_code_block(Scanner *s, TSLexer *lexer, uint8_t ticks) {
@@ -498,7 +612,7 @@ static bool parse_code_block(Scanner *s, TSLexer *lexer, uint8_t ticks) {
     return false;
   }
 
-  if (s->open_blocks->size > 0) {
+  if (s->open_blocks.size > 0) {
     // Code blocks can't contain other blocks, so we only look at the top.
     Block *top = peek_block(s);
     if (top->type == CODE_BLOCK) {
@@ -522,6 +636,89 @@ static bool parse_code_block(Scanner *s, TSLexer *lexer, uint8_t ticks) {
   return true;
 }
 
+// Code block and frontmatter content is split into tokens of whole lines,
+// ending after the line where they reach this many bytes. As with verbatim,
+// a smaller token means less to lex again after an edit.
+#define LINE_CHUNK_SIZE 4096
+
+// Consumes the rest of the line, including the `\n`.
+static uint32_t consume_line(TSLexer *lexer) {
+  uint32_t size = 0;
+  while (!lexer->eof(lexer) && lexer->lookahead != '\n') {
+    lexer->advance(lexer, false);
+    ++size;
+  }
+  if (!lexer->eof(lexer)) {
+    lexer->advance(lexer, false);
+    ++size;
+  }
+  return size;
+}
+
+// Output the lines of a code block up to the closing fence.
+//
+// Runs last in `scan`, after the parsers that may close the code block at
+// this line, and takes the rest of the line from wherever they left off.
+// Following lines are checked for the fence here. Inside block quotes and
+// lists a line may also close the code block with a missing `>`, its
+// indentation or a list marker, so there the token is a single line and
+// the next line goes through `scan` again.
+static bool parse_code_block_content(Scanner *s, TSLexer *lexer,
+                                     const bool *valid_symbols) {
+  Block *top = peek_block(s);
+  if (!valid_symbols[CODE_BLOCK_CONTENT] || !top || top->type != CODE_BLOCK) {
+    return false;
+  }
+
+  uint32_t size = consume_line(lexer);
+  lexer->mark_end(lexer);
+  s->block_quote_level = 0;
+  s->at_empty_line = false;
+  lexer->result_symbol = CODE_BLOCK_CONTENT;
+
+  if (find_block_quote(s) || find_list(s)) {
+    return true;
+  }
+  while (size < LINE_CHUNK_SIZE && !lexer->eof(lexer)) {
+    size += consume_whitespace(lexer);
+    uint8_t ticks = consume_chars(lexer, '`');
+    if (ticks == top->level) {
+      break;
+    }
+    size += ticks + consume_line(lexer);
+    lexer->mark_end(lexer);
+  }
+  return true;
+}
+
+// Output the lines of the frontmatter up to the closing `---`.
+//
+// Like code block content it runs last in `scan` and takes the rest of the
+// line. A following line starting with `-` ends the token, `parse_dash`
+// decides if it's the closing marker. An unclosed frontmatter has nothing
+// left at the end of input, where an empty token would repeat forever.
+static bool parse_frontmatter_content(Scanner *s, TSLexer *lexer,
+                                      const bool *valid_symbols) {
+  if (!valid_symbols[FRONTMATTER_CONTENT] || lexer->eof(lexer)) {
+    return false;
+  }
+
+  uint32_t size = consume_line(lexer);
+  lexer->mark_end(lexer);
+  s->at_empty_line = false;
+  lexer->result_symbol = FRONTMATTER_CONTENT;
+
+  while (size < LINE_CHUNK_SIZE && !lexer->eof(lexer)) {
+    size += consume_whitespace(lexer);
+    if (lexer->lookahead == '-') {
+      break;
+    }
+    size += consume_line(lexer);
+    lexer->mark_end(lexer);
+  }
+  return true;
+}
+
 static void output_verbatim_begin(Scanner *s, TSLexer *lexer, uint8_t ticks) {
   lexer->mark_end(lexer);
   s->verbatim_tick_count = ticks;
@@ -538,12 +735,28 @@ static bool try_close_verbatim(Scanner *s, TSLexer *lexer) {
   }
 }
 
+// Verbatim content is split into tokens of about this many bytes, which the
+// grammar joins into a single content node. Tree-sitter can only stop a parse
+// between tokens, and an edit inside a token invalidates all of it, so an
+// unclosed verbatim in a long paragraph shouldn't become a single token.
+#define VERBATIM_CHUNK_SIZE 1024
+
 // Parsing verbatim content is also responsible for parsing VERBATIM_END.
-static bool parse_verbatim_content(Scanner *s, TSLexer *lexer) {
+static bool parse_verbatim_content(Scanner *s, TSLexer *lexer,
+                                   const bool *valid_symbols) {
   if (s->verbatim_tick_count == 0) {
     return false;
   }
+  // Chunks are only split before a character that isn't whitespace, so
+  // another chunk never starts at a newline, even after the whitespace
+  // consumed by `scan`. If one would, the previous chunk ended at a
+  // blankline and the verbatim should be closed instead.
+  if (valid_symbols[VERBATIM_END] &&
+      (lexer->eof(lexer) || lexer->lookahead == '\n')) {
+    return false;
+  }
 
+  uint32_t size = 0;
   uint8_t ticks = 0;
   while (!lexer->eof(lexer)) {
     if (lexer->lookahead == '\n') {
@@ -552,6 +765,7 @@ static bool parse_verbatim_content(Scanner *s, TSLexer *lexer) {
 
       // Advance over the first newline.
       lexer->advance(lexer, false);
+      ++size;
       // Remove any whitespace on the next line.
       consume_whitespace(lexer);
       if (lexer->eof(lexer) || lexer->lookahead == '\n') {
@@ -566,6 +780,7 @@ static bool parse_verbatim_content(Scanner *s, TSLexer *lexer) {
     } else if (lexer->lookahead == '`') {
       // If we find a `, we need to count them to see if we should stop.
       uint8_t current = consume_chars(lexer, '`');
+      size += current;
       if (current == s->verbatim_tick_count) {
         // We found a matching number of `
         // We need to return VERBATIM_CONTENT then VERBATIM_END in the next
@@ -579,15 +794,23 @@ static bool parse_verbatim_content(Scanner *s, TSLexer *lexer) {
         lexer->mark_end(lexer);
         ticks = 0;
       }
+    } else if (size >= VERBATIM_CHUNK_SIZE && lexer->lookahead != ' ' &&
+               lexer->lookahead != '\t' && lexer->lookahead != '\r') {
+      // Leave the rest to the next chunk, which starts with this character.
+      break;
     } else {
       // Non-` token found, this we should consume.
       lexer->advance(lexer, false);
       lexer->mark_end(lexer);
+      ++size;
       ticks = 0;
     }
   }
 
-  // Scanned all the verbatim.
+  // Scanned all the verbatim, or as much as fits in this chunk. It only ends
+  // before an empty line when it's followed by a blankline, where the flag
+  // doesn't matter.
+  s->at_empty_line = false;
   lexer->result_symbol = VERBATIM_CONTENT;
   return true;
 }
@@ -660,6 +883,25 @@ static bool is_upper_roman(char c) {
   }
 }
 
+// The type of enumerator that starts with `c`.
+// We don't differentiate between alpha and roman lists, but prefer roman.
+static bool ordered_list_type(char c, OrderedListType *res) {
+  if (is_decimal(c)) {
+    *res = DECIMAL;
+  } else if (is_lower_roman(c)) {
+    *res = LOWER_ROMAN;
+  } else if (is_upper_roman(c)) {
+    *res = UPPER_ROMAN;
+  } else if (is_lower_alpha(c)) {
+    *res = LOWER_ALPHA;
+  } else if (is_upper_alpha(c)) {
+    *res = UPPER_ALPHA;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 static bool matches_ordered_list(OrderedListType type, char c) {
   switch (type) {
   case DECIMAL:
@@ -677,10 +919,10 @@ static bool matches_ordered_list(OrderedListType type, char c) {
   }
 }
 
-// Return true if we scan any character.
-static bool scan_ordered_list_enumerator(Scanner *s, TSLexer *lexer,
-                                         OrderedListType type) {
-  uint8_t scanned = 0;
+// Returns the number of scanned characters.
+static uint32_t scan_ordered_list_enumerator(Scanner *s, TSLexer *lexer,
+                                             OrderedListType type) {
+  uint32_t scanned = 0;
   while (!lexer->eof(lexer)) {
     // Note that we don't check if marker is a valid roman numeral.
     if (matches_ordered_list(type, lexer->lookahead)) {
@@ -690,33 +932,17 @@ static bool scan_ordered_list_enumerator(Scanner *s, TSLexer *lexer,
       break;
     }
   }
-  return scanned > 0;
+  return scanned;
 }
 
-static bool scan_ordered_list_type(Scanner *s, TSLexer *lexer,
-                                   OrderedListType *res) {
-  if (scan_ordered_list_enumerator(s, lexer, DECIMAL)) {
-    *res = DECIMAL;
-    return true;
-  }
-  // We don't differentiate between alpha and roman lists, but prefer roman.
-  if (scan_ordered_list_enumerator(s, lexer, LOWER_ROMAN)) {
-    *res = LOWER_ROMAN;
-    return true;
+// Returns the width of the enumerator, or 0 if there's none.
+static uint32_t scan_ordered_list_type(Scanner *s, TSLexer *lexer,
+                                       OrderedListType *res) {
+  // The first character decides the type, so the enumerator is scanned once.
+  if (lexer->eof(lexer) || !ordered_list_type(lexer->lookahead, res)) {
+    return 0;
   }
-  if (scan_ordered_list_enumerator(s, lexer, UPPER_ROMAN)) {
-    *res = UPPER_ROMAN;
-    return true;
-  }
-  if (scan_ordered_list_enumerator(s, lexer, LOWER_ALPHA)) {
-    *res = LOWER_ALPHA;
-    return true;
-  }
-  if (scan_ordered_list_enumerator(s, lexer, UPPER_ALPHA)) {
-    *res = UPPER_ALPHA;
-    return true;
-  }
-  return false;
+  return scan_ordered_list_enumerator(s, lexer, *res);
 }
 
 static TokenType scan_ordered_list_marker_token_type(Scanner *s,
@@ -729,7 +955,7 @@ static TokenType scan_ordered_list_marker_token_type(Scanner *s,
   }
 
   OrderedListType list_type;
-  if (!scan_ordered_list_type(s, lexer, &list_type)) {
+  if (scan_ordered_list_type(s, lexer, &list_type) == 0) {
     return IGNORED;
   }
 
@@ -882,7 +1108,7 @@ static bool scan_eof_or_blankline(Scanner *s, TSLexer *lexer) {
 // Can we scan a block closing marker?
 // For example, if we see a valid div marker.
 static bool scan_containing_block_closing_marker(Scanner *s, TSLexer *lexer) {
-  return is_div_marker_next(s, lexer) || scan_list_marker(s, lexer);
+  return is_div_marker_next(lexer) || scan_list_marker(s, lexer);
 }
 
 static bool close_paragraph(Scanner *s, TSLexer *lexer) {
@@ -1158,43 +1384,8 @@ static bool parse_colon(Scanner *s, TSLexer *lexer, const bool *valid_symbols) {
   }
 }
 
-static TokenType heading_start_token(uint8_t level) {
-  switch (level) {
-  case 1:
-    return HEADING1_BEGIN;
-  case 2:
-    return HEADING2_BEGIN;
-  case 3:
-    return HEADING3_BEGIN;
-  case 4:
-    return HEADING4_BEGIN;
-  case 5:
-    return HEADING5_BEGIN;
-  case 6:
-    return HEADING6_BEGIN;
-  default:
-    return ERROR;
-  }
-}
-
-static TokenType heading_continuation_token(uint8_t level) {
-  switch (level) {
-  case 1:
-    return HEADING1_CONTINUATION;
-  case 2:
-    return HEADING2_CONTINUATION;
-  case 3:
-    return HEADING3_CONTINUATION;
-  case 4:
-    return HEADING4_CONTINUATION;
-  case 5:
-    return HEADING5_CONTINUATION;
-  case 6:
-    return HEADING6_CONTINUATION;
-  default:
-    return ERROR;
-  }
-}
+// Headings are `#` up to `######`.
+#define MAX_HEADING_LEVEL 6
 
 static bool parse_heading(Scanner *s, TSLexer *lexer,
                           const bool *valid_symbols) {
@@ -1211,22 +1402,22 @@ static bool parse_heading(Scanner *s, TSLexer *lexer,
   uint8_t hash_count = consume_chars(lexer, '#');
 
   // We found a `# ` that can start or continue a heading.
+  // Too many `#` can't, but they still close an open heading.
   if (hash_count > 0 && lexer->lookahead == ' ') {
-    TokenType start_token = heading_start_token(hash_count);
-    TokenType continuation_token = heading_continuation_token(hash_count);
+    bool is_heading = hash_count <= MAX_HEADING_LEVEL;
+    bool can_begin = is_heading && valid_symbols[HEADING_BEGIN];
+    bool can_continue = is_heading && valid_symbols[HEADING_CONTINUATION];
 
-    if (!valid_symbols[start_token] && !valid_symbols[continuation_token] &&
-        !valid_symbols[BLOCK_CLOSE]) {
+    if (!can_begin && !can_continue && !valid_symbols[BLOCK_CLOSE]) {
       return false;
     }
 
     lexer->advance(lexer, false); // Consume the ' '.
 
-    if (valid_symbols[continuation_token] && top_heading &&
-        top->level == hash_count) {
+    if (can_continue && top_heading && top->level == hash_count) {
       // We're in a heading matching the same number of '#'.
       lexer->mark_end(lexer);
-      lexer->result_symbol = continuation_token;
+      lexer->result_symbol = HEADING_CONTINUATION;
       return true;
     }
 
@@ -1239,7 +1430,7 @@ static bool parse_heading(Scanner *s, TSLexer *lexer,
     }
 
     // Open a new heading.
-    if (valid_symbols[start_token]) {
+    if (can_begin) {
       // Sections are created on the root level (or nested inside other
       // sections). They should be closed when a header with the same or fewer
       // `#` is encountered, and then a new section should be started.
@@ -1255,7 +1446,7 @@ static bool parse_heading(Scanner *s, TSLexer *lexer,
 
       push_block(s, HEADING, hash_count);
       lexer->mark_end(lexer);
-      lexer->result_symbol = start_token;
+      lexer->result_symbol = HEADING_BEGIN;
       return true;
     }
   } else if (hash_count == 0 && top_heading) {
@@ -1274,9 +1465,8 @@ static bool parse_heading(Scanner *s, TSLexer *lexer,
     }
 
     // We should continue the heading, if it's open.
-    TokenType res = heading_continuation_token(top->level);
-    if (valid_symbols[res]) {
-      lexer->result_symbol = res;
+    if (valid_symbols[HEADING_CONTINUATION]) {
+      lexer->result_symbol = HEADING_CONTINUATION;
       return true;
     }
   }
@@ -1342,7 +1532,7 @@ static bool parse_block_quote(Scanner *s, TSLexer *lexer,
   uint8_t marker_count = s->block_quote_level + has_marker;
   size_t matching_block_pos =
       number_of_blocks_from_top(s, BLOCK_QUOTE, marker_count);
-  Block *highest_block_quote = find_block(s, BLOCK_QUOTE);
+  Block *highest_block_quote = find_block_quote(s);
 
   // There's an open block quote with a higher nesting level.
   if (highest_block_quote && marker_count < highest_block_quote->level) {
@@ -1371,6 +1561,7 @@ static bool parse_block_quote(Scanner *s, TSLexer *lexer,
     } else {
       s->block_quote_level = marker_count;
     }
+    s->at_empty_line = ending_newline && lexer->lookahead == '\n';
     lexer->result_symbol = BLOCK_QUOTE_CONTINUATION;
     return true;
   }
@@ -1385,6 +1576,7 @@ static bool parse_block_quote(Scanner *s, TSLexer *lexer,
     } else {
       s->block_quote_level = marker_count;
     }
+    s->at_empty_line = ending_newline && lexer->lookahead == '\n';
     lexer->result_symbol = BLOCK_QUOTE_BEGIN;
     return true;
   }
@@ -1409,6 +1601,111 @@ static bool parse_open_bracket(Scanner *s, TSLexer *lexer,
   return true;
 }
 
+// How far to look for the closer of a symbol before giving up,
+// which bounds the work for a paragraph full of unclosed symbols.
+#define UNCLOSED_SYMBOL_LOOKAHEAD 1024
+
+// Is `closer` found before the paragraph ends?
+// Says yes when it can't tell, such as inside block quotes where the blank
+// line has a marker, or when it gives up.
+static bool scan_closer(TSLexer *lexer, int32_t closer) {
+  bool empty_line = false;
+  for (uint32_t i = 0; i < UNCLOSED_SYMBOL_LOOKAHEAD; ++i) {
+    if (lexer->eof(lexer)) {
+      return false;
+    }
+    switch (lexer->lookahead) {
+    case '\n':
+      if (empty_line) {
+        return false;
+      }
+      empty_line = true;
+      break;
+    case ' ':
+    case '\t':
+    case '\r':
+      break;
+    default:
+      if (lexer->lookahead == closer) {
+        return true;
+      }
+      empty_line = false;
+      break;
+    }
+    lexer->advance(lexer, false);
+  }
+  return true;
+}
+
+// The `[`, `![`, `{` and `<` symbols only start markup if there's a `]`, `}`
+// or `>` later in the paragraph. Otherwise they're output as text, so the
+// parser doesn't have to try both the markup and `_symbol_fallback` until
+// the end of the paragraph.
+//
+// Only these symbols are covered, and only when no closer is found within
+// `UNCLOSED_SYMBOL_LOOKAHEAD` characters. A symbol with a closer, or whose
+// closer may be past the limit, still splits the parse stack. `_`, `*`, `^`
+// and `~` are left to the parser as they may close markup, and a symbol
+// after whitespace is left for the next scan, as the token would include
+// the whitespace. `make test-forks` checks the covered cases.
+static bool parse_unclosed_symbol(Scanner *s, TSLexer *lexer,
+                                  const bool *valid_symbols) {
+  if (!valid_symbols[UNCLOSED_SYMBOL] || s->whitespace > 0) {
+    return false;
+  }
+
+  int32_t closer;
+  switch (lexer->lookahead) {
+  case '!':
+    lexer->advance(lexer, false);
+    if (lexer->lookahead != '[') {
+      return false;
+    }
+    // fallthrough
+  case '[':
+    lexer->advance(lexer, false);
+    if (lexer->lookahead == '^') {
+      lexer->advance(lexer, false);
+    }
+    closer = ']';
+    break;
+  case '{':
+    lexer->advance(lexer, false);
+    switch (lexer->lookahead) {
+    // Quotation marks don't need a closer.
+    case '"':
+    case '\'':
+      return false;
+    case '*':
+    case '+':
+    case '-':
+    case '=':
+    case '^':
+    case '_':
+    case '~':
+      lexer->advance(lexer, false);
+      break;
+    default:
+      break;
+    }
+    closer = '}';
+    break;
+  case '<':
+    lexer->advance(lexer, false);
+    closer = '>';
+    break;
+  default:
+    return false;
+  }
+
+  lexer->mark_end(lexer);
+  if (scan_closer(lexer, closer)) {
+    return false;
+  }
+  lexer->result_symbol = UNCLOSED_SYMBOL;
+  return true;
+}
+
 static bool parse_footnote_end(Scanner *s, TSLexer *lexer,
                                const bool *valid_symbols) {
   if (!valid_symbols[FOOTNOTE_END]) {
@@ -1462,6 +1759,141 @@ static bool parse_table_caption_end(Scanner *s, TSLexer *lexer) {
   return true;
 }
 
+// Characters that never start inline markup, the same as in the `_text`
+// runs of `grammar.js`, with whitespace and the `.` and `-` of numbers.
+static bool is_plain_cell_char(int32_t c) {
+  switch (c) {
+  case '\n':
+  case '!':
+  case '"':
+  case '#':
+  case '$':
+  case '%':
+  case '\'':
+  case '(':
+  case ')':
+  case '*':
+  case '+':
+  case ':':
+  case '<':
+  case '=':
+  case '>':
+  case '[':
+  case '\\':
+  case ']':
+  case '^':
+  case '_':
+  case '`':
+  case '{':
+  case '|':
+  case '}':
+  case '~':
+    return false;
+  default:
+    return true;
+  }
+}
+
+// Words that are `todo`, `note` and `fixme` nodes.
+static bool is_highlight_word(const char *word, uint8_t length) {
+  static const char *highlights[] = {"TODO", "WIP",   "NOTE",
+                                     "INFO", "XXX",   "FIXME"};
+  for (size_t i = 0; i < sizeof(highlights) / sizeof(*highlights); ++i) {
+    if (strlen(highlights[i]) == length &&
+        memcmp(highlights[i], word, length) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The longest word in `is_highlight_word`.
+#define MAX_HIGHLIGHT_WORD 5
+
+// Consumes the rest of the line and returns true if it ends with an
+// unescaped `|`, as a table row must.
+static bool line_ends_row(TSLexer *lexer) {
+  int32_t last = 0;
+  int32_t before_last = 0;
+  while (!lexer->eof(lexer) && lexer->lookahead != '\n') {
+    int32_t c = lexer->lookahead;
+    if (c != ' ' && c != '\t' && c != '\r') {
+      before_last = last;
+      last = c;
+    }
+    lexer->advance(lexer, false);
+  }
+  return last == '|' && before_last != '\\';
+}
+
+// Output a table cell without any markup as a single token, up to the `|`
+// that ends it. Large tables are mostly made of such cells, which would
+// otherwise be a token for every word and space.
+//
+// Anything that may be markup is left to the inline rules: the cell isn't
+// emitted if it has a character that may start markup, a `..` or `--`,
+// or a highlighted word. An `|-` or `|:` may start a separator row.
+//
+// A line that doesn't end with `|` isn't a table row but a paragraph. The
+// grammar only finds out at the end of the line, by keeping a paragraph
+// version of the parse next to the table. The token would end that
+// version, so it's only emitted for lines that end like a row. The line is
+// only checked by the first of these cells in a row, `in_table_row` is set
+// if a previous cell already did.
+static bool parse_table_cell_text(Scanner *s, TSLexer *lexer,
+                                  const bool *valid_symbols,
+                                  bool in_table_row) {
+  if (!valid_symbols[TABLE_CELL_TEXT]) {
+    return false;
+  }
+  if (s->whitespace == 0 &&
+      (lexer->lookahead == '-' || lexer->lookahead == ':')) {
+    return false;
+  }
+
+  bool empty = s->whitespace == 0;
+  int32_t previous = 0;
+  char word[MAX_HIGHLIGHT_WORD];
+  // Longer words are counted as one more than the longest highlight.
+  uint8_t word_length = 0;
+  while (!lexer->eof(lexer)) {
+    int32_t c = lexer->lookahead;
+    bool in_word = c != '|' && c != ' ' && c != '\t' && c != '\r' &&
+                   c != '.' && c != '-';
+    if (in_word) {
+      if (word_length < MAX_HIGHLIGHT_WORD) {
+        word[word_length] = (char)c;
+      }
+      if (word_length <= MAX_HIGHLIGHT_WORD) {
+        ++word_length;
+      }
+    } else {
+      if (is_highlight_word(word, word_length)) {
+        return false;
+      }
+      word_length = 0;
+    }
+
+    if (c == '|') {
+      if (empty) {
+        return false;
+      }
+      lexer->mark_end(lexer);
+      lexer->result_symbol = TABLE_CELL_TEXT;
+      s->in_table_row = in_table_row || line_ends_row(lexer);
+      return s->in_table_row;
+    }
+    if (!is_plain_cell_char(c) ||
+        ((c == '.' || c == '-') && c == previous)) {
+      return false;
+    }
+    previous = c;
+    empty = false;
+    lexer->advance(lexer, false);
+  }
+  return false;
+}
+
 static bool end_paragraph_in_block_quote(Scanner *s, TSLexer *lexer) {
   Block *top = peek_block(s);
   if (!top || top->type != BLOCK_QUOTE) {
@@ -1501,14 +1933,14 @@ static bool end_paragraph_in_block_quote(Scanner *s, TSLexer *lexer) {
 //
 // We should have already advanced over `\n` before calling this function.
 static bool emit_newline_inline(Scanner *s, TSLexer *lexer,
-                                uint32_t newline_column) {
+                                bool first_in_line) {
   // Need a proper `NEWLINE` to end a paragraph.
   if (lexer->eof(lexer)) {
     return false;
   }
 
   // Is never valid as the first character of a line.
-  if (newline_column == 0) {
+  if (first_in_line) {
     return false;
   }
 
@@ -1555,18 +1987,19 @@ static bool parse_newline(Scanner *s, TSLexer *lexer,
     return false;
   }
 
-  uint32_t newline_column = lexer->get_column(lexer);
+  bool first_in_line = s->at_empty_line && s->whitespace == 0;
 
   if (lexer->lookahead == '\n') {
     lexer->advance(lexer, false);
   }
   lexer->mark_end(lexer);
+  s->at_empty_line = lexer->lookahead == '\n';
 
   // Prefer NEWLINE_INLINE for newlines in inline context.
   // When they're no longer accepted, this marks the end of a paragraph
   // and a regular NEWLINE (or EOF_OR_BLANKLINE) can be emitted.
   if (valid_symbols[NEWLINE_INLINE] &&
-      emit_newline_inline(s, lexer, newline_column)) {
+      emit_newline_inline(s, lexer, first_in_line)) {
     lexer->result_symbol = NEWLINE_INLINE;
     return true;
   }
@@ -1588,6 +2021,23 @@ static bool parse_newline(Scanner *s, TSLexer *lexer,
   return false;
 }
 
+// Is any ordered list marker a valid symbol?
+static bool ordered_list_marker_valid(const bool *valid_symbols) {
+  for (int i = LIST_MARKER_DECIMAL_PERIOD; i <= LIST_MARKER_UPPER_ROMAN_PARENS;
+       ++i) {
+    if (valid_symbols[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Can `c` start an ordered list marker, like `1.`, `a)` or `(i)`?
+static bool is_ordered_list_marker_start(int32_t c) {
+  return c == '(' || ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') ||
+         ('A' <= c && c <= 'Z');
+}
+
 #ifdef DEBUG
 static void dump(Scanner *s, TSLexer *lexer);
 static void dump_valid_symbols(const bool *valid_symbols);
@@ -1609,11 +2059,24 @@ bool tree_sitter_djot_external_scanner_scan(void *payload, TSLexer *lexer,
   // I found it easier to opt-in to consume tokens.
   lexer->mark_end(lexer);
   s->whitespace = consume_whitespace(lexer);
-  bool is_newline = lexer->lookahead == '\n';
+  int32_t first = lexer->lookahead;
+  bool is_newline = first == '\n';
 
   if (is_newline) {
     s->block_quote_level = 0;
   }
+  // Tokens that don't start at the `\n` can't end at the start of an
+  // empty line, except for those that set the flag again.
+  if (!is_newline || s->whitespace > 0) {
+    s->at_empty_line = false;
+  }
+  bool in_table_row = s->in_table_row;
+  s->in_table_row = false;
+
+  // All symbols are valid during error recovery. The parsers that consume
+  // large spans of text would swallow whatever the parser tries to recover
+  // from, and only run where their token is actually expected.
+  bool error_recovery = valid_symbols[ERROR];
 
   if (valid_symbols[BLOCK_CLOSE] && handle_blocks_to_close(s, lexer)) {
     return true;
@@ -1633,7 +2096,9 @@ bool tree_sitter_djot_external_scanner_scan(void *payload, TSLexer *lexer,
     return true;
   }
 
-  if (parse_block_quote(s, lexer, valid_symbols)) {
+  // Without a `>` a block quote can only be closed.
+  if ((lexer->lookahead == '>' || valid_symbols[BLOCK_CLOSE]) &&
+      parse_block_quote(s, lexer, valid_symbols)) {
     return true;
   }
   if (valid_symbols[CLOSE_PARAGRAPH] && parse_close_paragraph(s, lexer)) {
@@ -1648,7 +2113,8 @@ bool tree_sitter_djot_external_scanner_scan(void *payload, TSLexer *lexer,
 
   // Verbatim content parsing is responsible for setting VERBATIM_END
   // for normal instances as well.
-  if (valid_symbols[VERBATIM_CONTENT] && parse_verbatim_content(s, lexer)) {
+  if (valid_symbols[VERBATIM_CONTENT] &&
+      parse_verbatim_content(s, lexer, valid_symbols)) {
     return true;
   }
   if (valid_symbols[VERBATIM_END] && lexer->eof) {
@@ -1705,11 +2171,18 @@ bool tree_sitter_djot_external_scanner_scan(void *payload, TSLexer *lexer,
 
   // Scan ordered list markers outside because the parsing may conflict with
   // closing of lists (both may try to parse the same characters).
-  TokenType ordered_list_marker = scan_ordered_list_marker_token(s, lexer);
-  if (ordered_list_marker != IGNORED &&
-      handle_ordered_list_marker(s, lexer, valid_symbols,
-                                 ordered_list_marker)) {
-    return true;
+  // Inside inline content neither is valid, and there's no need to scan
+  // the start of every word.
+  TokenType ordered_list_marker = IGNORED;
+  if (is_ordered_list_marker_start(lexer->lookahead) &&
+      (valid_symbols[BLOCK_CLOSE] ||
+       ordered_list_marker_valid(valid_symbols))) {
+    ordered_list_marker = scan_ordered_list_marker_token(s, lexer);
+    if (ordered_list_marker != IGNORED &&
+        handle_ordered_list_marker(s, lexer, valid_symbols,
+                                   ordered_list_marker)) {
+      return true;
+    }
   }
 
   if (valid_symbols[TABLE_CAPTION_END] && parse_table_caption_end(s, lexer)) {
@@ -1728,79 +2201,247 @@ bool tree_sitter_djot_external_scanner_scan(void *payload, TSLexer *lexer,
     return true;
   }
 
+  if (!error_recovery &&
+      parse_code_block_content(s, lexer, valid_symbols)) {
+    return true;
+  }
+  if (!error_recovery &&
+      parse_frontmatter_content(s, lexer, valid_symbols)) {
+    return true;
+  }
+
   if (valid_symbols[EOF_OR_BLANKLINE] && lexer->eof(lexer)) {
     lexer->result_symbol = EOF_OR_BLANKLINE;
     return true;
   }
 
+  // Last, as it looks ahead to the end of the paragraph. Where a footnote may
+  // begin `parse_open_bracket` has consumed the `[`, and a `{` may be a block
+  // attribute, so it's only tried inside paragraphs.
+  if (!error_recovery && !valid_symbols[FOOTNOTE_BEGIN] &&
+      parse_unclosed_symbol(s, lexer, valid_symbols)) {
+    return true;
+  }
+  // The other parsers only consume characters that can't be in a plain cell.
+  if (!error_recovery && is_plain_cell_char(first) &&
+      parse_table_cell_text(s, lexer, valid_symbols, in_table_row)) {
+    return true;
+  }
+
   return false;
 }
 
+// Reset the scanner state, keeping the capacity of `open_blocks`.
 void init(Scanner *s) {
-  array_init(s->open_blocks);
+  // The block indices are left as is, see `indexed_block`.
+  array_clear(&s->open_blocks);
   s->blocks_to_close = 0;
   s->delayed_token = IGNORED;
   s->delayed_token_width = 0;
   s->verbatim_tick_count = 0;
   s->block_quote_level = 0;
+  s->at_empty_line = false;
+  s->in_table_row = false;
   s->whitespace = 0;
 }
 
 void *tree_sitter_djot_external_scanner_create() {
   Scanner *s = (Scanner *)ts_malloc(sizeof(Scanner));
-  s->open_blocks = ts_malloc(sizeof(Array(Block *)));
+  array_init(&s->open_blocks);
+  s->top_list = NO_BLOCK;
+  s->top_block_quote = NO_BLOCK;
+  for (size_t i = 0; i <= UINT8_MAX; ++i) {
+    s->top_block_quote_of_level[i] = NO_BLOCK;
+    s->top_div_of_level[i] = NO_BLOCK;
+  }
   init(s);
   return s;
 }
 
 void tree_sitter_djot_external_scanner_destroy(void *payload) {
   Scanner *s = (Scanner *)payload;
-  for (size_t i = 0; i < s->open_blocks->size; ++i) {
-    ts_free(*array_get(s->open_blocks, i));
-  }
-  array_delete(s->open_blocks);
+  array_delete(&s->open_blocks);
   ts_free(s);
 }
 
+// The serialized state is compact, as tree-sitter stores it for every
+// external token and compares states with `memcmp`.
+//
+// The initial state serializes to zero bytes. Otherwise the state starts
+// with a header byte, containing the format version and a bit for each
+// scalar field that's non-zero. Only those fields follow, one byte each,
+// except for boolean fields that are stored in the header alone.
+//
+// Tree-sitter only reuses subtrees when the states are identical,
+// so equivalent states must serialize identically. Fields that are
+// recalculated on every scan (`whitespace`), or that are only meaningful
+// together with another field (`delayed_token_width`), are left out.
+//
+// Open blocks are stored as runs, from the bottom of the stack.
+// Each run starts with a byte containing the block type and flags:
+//
+//   - `RUN_REPEATED`: a byte with the number of extra blocks follows.
+//   - `RUN_NESTED`: each block in the run has a level one higher than
+//     the previous, as with nested block quotes (`> > >`).
+//
+// followed by the level of the first block in the run.
+//
+// Stacks that don't fit in the buffer are truncated at the top,
+// which won't parse correctly but won't overflow the buffer either.
+#define SERIALIZATION_VERSION 3
+
+#define HEADER_VERSION_SHIFT 6
+#define HEADER_BLOCKS_TO_CLOSE (1 << 0)
+#define HEADER_DELAYED_TOKEN (1 << 1)
+#define HEADER_VERBATIM_TICK_COUNT (1 << 2)
+#define HEADER_BLOCK_QUOTE_LEVEL (1 << 3)
+#define HEADER_AT_EMPTY_LINE (1 << 4)
+#define HEADER_IN_TABLE_ROW (1 << 5)
+
+#define RUN_TYPE_MASK 0x1f
+#define RUN_REPEATED (1 << 5)
+#define RUN_NESTED (1 << 6)
+#define RUN_MAX_BYTES 3
+#define RUN_MAX_LENGTH (UINT8_MAX + 1)
+
+// Returns the length of the run starting at `start`, and sets `nested`
+// if the levels are increasing.
+static size_t block_run_length(Scanner *s, size_t start, bool *nested) {
+  Block *first = array_get(&s->open_blocks, start);
+  *nested = false;
+  if (start + 1 >= s->open_blocks.size) {
+    return 1;
+  }
+  Block *next = array_get(&s->open_blocks, start + 1);
+  if (next->type != first->type ||
+      (next->level != first->level && next->level != first->level + 1)) {
+    return 1;
+  }
+  *nested = next->level != first->level;
+
+  size_t length = 1;
+  while (start + length < s->open_blocks.size && length < RUN_MAX_LENGTH) {
+    Block *b = array_get(&s->open_blocks, start + length);
+    uint8_t expected = first->level + (*nested ? length : 0);
+    if (b->type != first->type || b->level != expected) {
+      break;
+    }
+    ++length;
+  }
+  return length;
+}
+
 unsigned tree_sitter_djot_external_scanner_serialize(void *payload,
                                                      char *buffer) {
   Scanner *s = (Scanner *)payload;
+  uint8_t header = 0;
+  if (s->blocks_to_close) {
+    header |= HEADER_BLOCKS_TO_CLOSE;
+  }
+  if (s->delayed_token != IGNORED) {
+    header |= HEADER_DELAYED_TOKEN;
+  }
+  if (s->verbatim_tick_count) {
+    header |= HEADER_VERBATIM_TICK_COUNT;
+  }
+  if (s->block_quote_level) {
+    header |= HEADER_BLOCK_QUOTE_LEVEL;
+  }
+  if (s->at_empty_line) {
+    header |= HEADER_AT_EMPTY_LINE;
+  }
+  if (s->in_table_row) {
+    header |= HEADER_IN_TABLE_ROW;
+  }
+  if (header == 0 && s->open_blocks.size == 0) {
+    return 0;
+  }
+
   unsigned size = 0;
-  buffer[size++] = (char)s->blocks_to_close;
-  buffer[size++] = (char)s->delayed_token;
-  buffer[size++] = (char)s->delayed_token_width;
-  buffer[size++] = (char)s->verbatim_tick_count;
-  buffer[size++] = (char)s->block_quote_level;
-  buffer[size++] = (char)s->whitespace;
-
-  for (size_t i = 0; i < s->open_blocks->size; ++i) {
-    Block *b = *array_get(s->open_blocks, i);
-    buffer[size++] = (char)b->type;
+  buffer[size++] = (char)(header | SERIALIZATION_VERSION
+                                       << HEADER_VERSION_SHIFT);
+  if (header & HEADER_BLOCKS_TO_CLOSE) {
+    buffer[size++] = (char)s->blocks_to_close;
+  }
+  if (header & HEADER_DELAYED_TOKEN) {
+    buffer[size++] = (char)s->delayed_token;
+    buffer[size++] = (char)s->delayed_token_width;
+  }
+  if (header & HEADER_VERBATIM_TICK_COUNT) {
+    buffer[size++] = (char)s->verbatim_tick_count;
+  }
+  if (header & HEADER_BLOCK_QUOTE_LEVEL) {
+    buffer[size++] = (char)s->block_quote_level;
+  }
+
+  size_t i = 0;
+  while (i < s->open_blocks.size &&
+         size + RUN_MAX_BYTES <= TREE_SITTER_SERIALIZATION_BUFFER_SIZE) {
+    Block *b = array_get(&s->open_blocks, i);
+    bool nested;
+    size_t length = block_run_length(s, i, &nested);
+    uint8_t run = (uint8_t)b->type;
+    if (length > 1) {
+      run |= RUN_REPEATED;
+    }
+    if (nested) {
+      run |= RUN_NESTED;
+    }
+    buffer[size++] = (char)run;
+    if (length > 1) {
+      buffer[size++] = (char)(length - 1);
+    }
     buffer[size++] = (char)b->level;
+    i += length;
   }
 
   return size;
 }
 
-void tree_sitter_djot_external_scanner_deserialize(void *payload, char *buffer,
+void tree_sitter_djot_external_scanner_deserialize(void *payload,
+                                                   const char *buffer,
                                                    unsigned length) {
   Scanner *s = (Scanner *)payload;
   init(s);
-  if (length > 0) {
-    size_t size = 0;
-    s->blocks_to_close = (uint8_t)buffer[size++];
-    s->delayed_token = (TokenType)buffer[size++];
-    s->delayed_token_width = (uint8_t)buffer[size++];
-    s->verbatim_tick_count = (uint8_t)buffer[size++];
-    s->block_quote_level = (uint8_t)buffer[size++];
-    s->whitespace = (uint8_t)buffer[size++];
+  if (length == 0) {
+    return;
+  }
+
+  uint8_t header = (uint8_t)buffer[0];
+  if (header >> HEADER_VERSION_SHIFT != SERIALIZATION_VERSION) {
+    return;
+  }
+
+  size_t size = 1;
+#define READ_BYTE() (size < length ? (uint8_t)buffer[size++] : 0)
+  if (header & HEADER_BLOCKS_TO_CLOSE) {
+    s->blocks_to_close = READ_BYTE();
+  }
+  if (header & HEADER_DELAYED_TOKEN) {
+    s->delayed_token = (TokenType)READ_BYTE();
+    s->delayed_token_width = READ_BYTE();
+  }
+  if (header & HEADER_VERBATIM_TICK_COUNT) {
+    s->verbatim_tick_count = READ_BYTE();
+  }
+  if (header & HEADER_BLOCK_QUOTE_LEVEL) {
+    s->block_quote_level = READ_BYTE();
+  }
+  s->at_empty_line = header & HEADER_AT_EMPTY_LINE;
+  s->in_table_row = header & HEADER_IN_TABLE_ROW;
 
-    while (size < length) {
-      BlockType type = (BlockType)buffer[size++];
-      uint8_t level = (uint8_t)buffer[size++];
-      array_push(s->open_blocks, create_block(type, level));
+  while (size < length) {
+    uint8_t run = READ_BYTE();
+    size_t run_length = run & RUN_REPEATED ? (size_t)READ_BYTE() + 1 : 1;
+    uint8_t level = READ_BYTE();
+    for (size_t i = 0; i < run_length; ++i) {
+      array_push(&s->open_blocks,
+                 ((Block){.type = (BlockType)(run & RUN_TYPE_MASK),
+                          .level = run & RUN_NESTED ? level + i : level}));
     }
   }
+#undef READ_BYTE
+  index_blocks(s);
 }
 
 #ifdef DEBUG
@@ -1818,31 +2459,13 @@ static char *token_type_s(TokenType t) {
 
   case FRONTMATTER_MARKER:
     return "FRONTMATTER_MARKER";
+  case FRONTMATTER_CONTENT:
+    return "FRONTMATTER_CONTENT";
 
-  case HEADING1_BEGIN:
-    return "HEADING1_BEGIN";
-  case HEADING1_CONTINUATION:
-    return "HEADING1_CONTINUATION";
-  case HEADING2_BEGIN:
-    return "HEADING2_BEGIN";
-  case HEADING2_CONTINUATION:
-    return "HEADING2_CONTINUATION";
-  case HEADING3_BEGIN:
-    return "HEADING3_BEGIN";
-  case HEADING3_CONTINUATION:
-    return "HEADING3_CONTINUATION";
-  case HEADING4_BEGIN:
-    return "HEADING4_BEGIN";
-  case HEADING4_CONTINUATION:
-    return "HEADING4_CONTINUATION";
-  case HEADING5_BEGIN:
-    return "HEADING5_BEGIN";
-  case HEADING5_CONTINUATION:
-    return "HEADING5_CONTINUATION";
-  case HEADING6_BEGIN:
-    return "HEADING6_BEGIN";
-  case HEADING6_CONTINUATION:
-    return "HEADING6_CONTINUATION";
+  case HEADING_BEGIN:
+    return "HEADING_BEGIN";
+  case HEADING_CONTINUATION:
+    return "HEADING_CONTINUATION";
   case DIV_BEGIN:
     return "DIV_BEGIN";
   case DIV_END:
@@ -1851,6 +2474,8 @@ static char *token_type_s(TokenType t) {
     return "CODE_BLOCK_BEGIN";
   case CODE_BLOCK_END:
     return "CODE_BLOCK_END";
+  case CODE_BLOCK_CONTENT:
+    return "CODE_BLOCK_CONTENT";
   case LIST_MARKER_DASH:
     return "LIST_MARKER_DASH";
   case LIST_MARKER_STAR:
@@ -1911,6 +2536,8 @@ static char *token_type_s(TokenType t) {
     return "TABLE_CAPTION_BEGIN";
   case TABLE_CAPTION_END:
     return "TABLE_CAPTION_END";
+  case TABLE_CELL_TEXT:
+    return "TABLE_CELL_TEXT";
 
   case VERBATIM_BEGIN:
     return "VERBATIM_BEGIN";
@@ -1918,6 +2545,8 @@ static char *token_type_s(TokenType t) {
     return "VERBATIM_END";
   case VERBATIM_CONTENT:
     return "VERBATIM_CONTENT";
+  case UNCLOSED_SYMBOL:
+    return "UNCLOSED_SYMBOL";
 
   case ERROR:
     return "ERROR";
@@ -1990,9 +2619,9 @@ static char *block_type_s(BlockType t) {
 }
 
 static void dump_scanner(Scanner *s) {
-  printf("--- Open blocks: %u (last -> first)\n", s->open_blocks->size);
-  for (size_t i = 0; i < s->open_blocks->size; ++i) {
-    Block *b = *array_get(s->open_blocks, i);
+  printf("--- Open blocks: %u (last -> first)\n", s->open_blocks.size);
+  for (size_t i = 0; i < s->open_blocks.size; ++i) {
+    Block *b = array_get(&s->open_blocks, i);
     printf("  %d %s\n", b->level, block_type_s(b->type));
   }
   printf("---\n");
@@ -2003,6 +2632,8 @@ static void dump_scanner(Scanner *s) {
   }
   printf("  verbatim_tick_count: %u\n", s->verbatim_tick_count);
   printf("  block_quote_level: %u\n", s->block_quote_level);
+  printf("  at_empty_line: %d\n", s->at_empty_line);
+  printf("  in_table_row: %d\n", s->in_table_row);
   printf("  whitespace: %u\n", s->whitespace);
   printf("===\n");
 }
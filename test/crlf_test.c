@@ -0,0 +1,353 @@
+// Tests of the CRLF normalizing input of bindings/c/tree-sitter-djot-crlf.h,
+// see `make test-crlf`.
+//
+// The input is read from every offset of texts with lone `\r`s and CRLFs at
+// the start, at the end and around the chunk size, and the byte and point
+// mappings are checked both ways. Parses through the input, fresh and after
+// edits that split and join CRLFs, have to give the tree of the normalized
+// text.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tree_sitter/api.h>
+
+#include "tree-sitter-djot-crlf.h"
+
+const TSLanguage *tree_sitter_djot(void);
+
+static int failures = 0;
+
+#define CHECK(condition, ...)                                                  \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      ++failures;                                                              \
+      fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);                          \
+      fprintf(stderr, __VA_ARGS__);                                            \
+      fputc('\n', stderr);                                                     \
+    }                                                                          \
+  } while (0)
+
+typedef struct {
+  char *text;
+  uint32_t length;
+} Text;
+
+static Text text_new(const char *text, uint32_t length) {
+  Text result = {malloc(length + 1), length};
+  memcpy(result.text, text, length);
+  result.text[length] = '\0';
+  return result;
+}
+
+// The text the parser should see: every `\r` before a `\n` left out.
+static Text normalize(const char *text, uint32_t length) {
+  Text result = {malloc(length + 1), 0};
+  for (uint32_t i = 0; i < length; ++i) {
+    if (!(text[i] == '\r' && i + 1 < length && text[i + 1] == '\n')) {
+      result.text[result.length++] = text[i];
+    }
+  }
+  result.text[result.length] = '\0';
+  return result;
+}
+
+static TSPoint point_at(const char *text, uint32_t byte) {
+  TSPoint point = {0, 0};
+  for (uint32_t i = 0; i < byte; ++i) {
+    if (text[i] == '\n') {
+      ++point.row;
+      point.column = 0;
+    } else {
+      ++point.column;
+    }
+  }
+  return point;
+}
+
+static bool point_equal(TSPoint a, TSPoint b) {
+  return a.row == b.row && a.column == b.column;
+}
+
+static void check_reads(const char *name, const char *text, uint32_t length) {
+  Text expected = normalize(text, length);
+  DjotCrlfInput *input = djot_crlf_input_new(text, length);
+  CHECK(input, "%s: out of memory", name);
+  if (!input) {
+    return;
+  }
+  TSInput ts_input = djot_crlf_input(input);
+  for (uint32_t from = 0; from <= expected.length; ++from) {
+    uint32_t size;
+    const char *chunk =
+        ts_input.read(ts_input.payload, from, point_at(expected.text, from),
+                      &size);
+    uint32_t left = expected.length - from;
+    uint32_t want = left < DJOT_CRLF_CHUNK_SIZE ? left : DJOT_CRLF_CHUNK_SIZE;
+    CHECK(size == want, "%s: read at %u gave %u bytes, not %u", name, from,
+          size, want);
+    if (size == want) {
+      CHECK(memcmp(chunk, expected.text + from, size) == 0,
+            "%s: read at %u gave other text", name, from);
+    }
+  }
+  djot_crlf_input_delete(input);
+  free(expected.text);
+}
+
+static void check_mappings(const char *name, const char *text,
+                           uint32_t length) {
+  Text expected = normalize(text, length);
+  DjotCrlfInput *input = djot_crlf_input_new(text, length);
+  CHECK(input, "%s: out of memory", name);
+  if (!input) {
+    return;
+  }
+
+  for (uint32_t byte = 0; byte <= expected.length; ++byte) {
+    uint32_t original = djot_crlf_original_byte(input, byte);
+    CHECK(djot_crlf_normalized_byte(input, original) == byte,
+          "%s: normalized byte %u maps to %u and back to %u", name, byte,
+          original, djot_crlf_normalized_byte(input, original));
+    if (byte < expected.length) {
+      CHECK(text[original] == expected.text[byte],
+            "%s: normalized byte %u maps to another character", name, byte);
+    }
+    TSPoint point = djot_crlf_original_point(
+        input, byte, point_at(expected.text, byte));
+    CHECK(point_equal(point, point_at(text, original)),
+          "%s: point of normalized byte %u is %u:%u, not %u:%u", name, byte,
+          point.row, point.column, point_at(text, original).row,
+          point_at(text, original).column);
+  }
+
+  for (uint32_t byte = 0; byte <= length; ++byte) {
+    uint32_t normalized = djot_crlf_normalized_byte(input, byte);
+    TSPoint point =
+        djot_crlf_normalized_point(input, byte, point_at(text, byte));
+    CHECK(point_equal(point, point_at(expected.text, normalized)),
+          "%s: point of original byte %u is %u:%u, not %u:%u", name, byte,
+          point.row, point.column, point_at(expected.text, normalized).row,
+          point_at(expected.text, normalized).column);
+    if (byte + 1 < length && text[byte] == '\r' && text[byte + 1] == '\n') {
+      CHECK(normalized == djot_crlf_normalized_byte(input, byte + 1),
+            "%s: the `\\r` of the CRLF at %u maps apart from its `\\n`", name,
+            byte);
+    }
+  }
+
+  djot_crlf_input_delete(input);
+  free(expected.text);
+}
+
+static char *parse_string(TSParser *parser, const char *text,
+                          uint32_t length) {
+  TSTree *tree = ts_parser_parse_string(parser, NULL, text, length);
+  char *string = ts_node_string(ts_tree_root_node(tree));
+  ts_tree_delete(tree);
+  return string;
+}
+
+static char *parse_input(TSParser *parser, TSTree *old_tree,
+                         DjotCrlfInput *input, TSTree **tree) {
+  *tree = ts_parser_parse(parser, old_tree, djot_crlf_input(input));
+  return ts_node_string(ts_tree_root_node(*tree));
+}
+
+// Replace `removed` bytes at `start` with `inserted`, through the input and
+// an incremental reparse, and compare the tree with a parse of the normalized
+// new text.
+static void check_edit(TSParser *parser, const char *name, Text *text,
+                       DjotCrlfInput *input, TSTree **tree, uint32_t start,
+                       uint32_t removed, const char *inserted) {
+  uint32_t inserted_length = (uint32_t)strlen(inserted);
+  Text edited = {malloc(text->length - removed + inserted_length + 1),
+                 text->length - removed + inserted_length};
+  memcpy(edited.text, text->text, start);
+  memcpy(edited.text + start, inserted, inserted_length);
+  memcpy(edited.text + start + inserted_length, text->text + start + removed,
+         text->length - start - removed);
+  edited.text[edited.length] = '\0';
+
+  TSInputEdit edit = {
+      start,
+      start + removed,
+      start + inserted_length,
+      point_at(text->text, start),
+      point_at(text->text, start + removed),
+      point_at(edited.text, start + inserted_length),
+  };
+  CHECK(djot_crlf_input_edit(input, edited.text, edited.length, &edit),
+        "%s: out of memory", name);
+
+  // The converted edit has to describe the change of the normalized text:
+  // what's before the start and after the ends is the same.
+  Text old_normalized = normalize(text->text, text->length);
+  Text normalized = normalize(edited.text, edited.length);
+  bool valid = edit.start_byte <= edit.old_end_byte &&
+               edit.start_byte <= edit.new_end_byte &&
+               edit.old_end_byte <= old_normalized.length &&
+               edit.new_end_byte <= normalized.length &&
+               old_normalized.length - edit.old_end_byte ==
+                   normalized.length - edit.new_end_byte;
+  CHECK(valid, "%s: edit %u-%u-%u doesn't fit texts of %u and %u bytes", name,
+        edit.start_byte, edit.old_end_byte, edit.new_end_byte,
+        old_normalized.length, normalized.length);
+  if (valid) {
+    CHECK(memcmp(old_normalized.text, normalized.text, edit.start_byte) == 0 &&
+              memcmp(old_normalized.text + edit.old_end_byte,
+                     normalized.text + edit.new_end_byte,
+                     normalized.length - edit.new_end_byte) == 0,
+          "%s: edit %u-%u-%u leaves out changed text", name, edit.start_byte,
+          edit.old_end_byte, edit.new_end_byte);
+    CHECK(point_equal(edit.start_point,
+                      point_at(normalized.text, edit.start_byte)) &&
+              point_equal(edit.old_end_point,
+                          point_at(old_normalized.text, edit.old_end_byte)) &&
+              point_equal(edit.new_end_point,
+                          point_at(normalized.text, edit.new_end_byte)),
+          "%s: edit points don't match its bytes", name);
+  }
+  free(old_normalized.text);
+  ts_tree_edit(*tree, &edit);
+
+  TSTree *old_tree = *tree;
+  char *reparsed = parse_input(parser, old_tree, input, tree);
+  ts_tree_delete(old_tree);
+  char *expected = parse_string(parser, normalized.text, normalized.length);
+  CHECK(strcmp(reparsed, expected) == 0,
+        "%s: reparse gave\n  %s\nnot\n  %s", name, reparsed, expected);
+  CHECK(ts_node_end_byte(ts_tree_root_node(*tree)) == normalized.length,
+        "%s: tree ends at %u, not %u", name,
+        ts_node_end_byte(ts_tree_root_node(*tree)), normalized.length);
+
+  free(reparsed);
+  free(expected);
+  free(normalized.text);
+  free(text->text);
+  *text = edited;
+}
+
+static void check_parse_and_edits(TSParser *parser) {
+  static const char document[] =
+      "# Heading\r\n"
+      "\r\n"
+      "Text with _emphasis_ and a lone\rcarriage return\r\n"
+      "continued here.\r\n"
+      "\r\n"
+      "- item\r\n"
+      "- item\r\n"
+      "\r\n"
+      "``` c\r\n"
+      "int x;\r\n"
+      "```\r\n"
+      "\r\n"
+      "| a | b |\r\n"
+      "|---|---|\r\n"
+      "| c | d |\r\n"
+      "\r\n"
+      "> quoted\r\n"
+      "> text\r";
+  Text text = text_new(document, sizeof(document) - 1);
+  DjotCrlfInput *input = djot_crlf_input_new(text.text, text.length);
+  CHECK(input, "out of memory");
+  if (!input) {
+    return;
+  }
+
+  TSTree *tree;
+  char *parsed = parse_input(parser, NULL, input, &tree);
+  Text normalized = normalize(text.text, text.length);
+  char *expected = parse_string(parser, normalized.text, normalized.length);
+  CHECK(strcmp(parsed, expected) == 0, "parse gave\n  %s\nnot\n  %s", parsed,
+        expected);
+  free(parsed);
+  free(expected);
+  free(normalized.text);
+
+  const char *heading_end = strstr(text.text, "\r\n");
+  uint32_t cr = (uint32_t)(heading_end - text.text);
+  check_edit(parser, "split a CRLF", &text, input, &tree, cr + 1, 0, "x");
+  check_edit(parser, "join a CRLF", &text, input, &tree, cr + 1, 1, "");
+  check_edit(parser, "insert after a `\\r`", &text, input, &tree, cr + 1, 0,
+             "\r\n");
+  check_edit(parser, "remove the `\\r` of a CRLF", &text, input, &tree, cr, 1,
+             "");
+  check_edit(parser, "add a `\\r` before a `\\n`", &text, input, &tree, cr, 0,
+             "\r");
+  check_edit(parser, "end with a lone `\\r`", &text, input, &tree,
+             text.length, 0, "\r\r");
+  check_edit(parser, "complete the last CRLF", &text, input, &tree,
+             text.length, 0, "\n");
+
+  // Random edits of characters that change lines and markup.
+  static const char *pieces[] = {"\r", "\n", "\r\n", "a", " ", "*", "# ", "- "};
+  unsigned seed = 1;
+  for (int i = 0; i < 200; ++i) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t start = (seed >> 8) % (text.length + 1);
+    seed = seed * 1103515245 + 12345;
+    uint32_t removed = (seed >> 8) % 3;
+    if (removed > text.length - start) {
+      removed = text.length - start;
+    }
+    seed = seed * 1103515245 + 12345;
+    const char *inserted =
+        (seed >> 8) % 4 ? pieces[(seed >> 12) % 8] : "";
+    char name[64];
+    snprintf(name, sizeof(name), "random edit %d", i);
+    check_edit(parser, name, &text, input, &tree, start, removed, inserted);
+  }
+
+  ts_tree_delete(tree);
+  djot_crlf_input_delete(input);
+  free(text.text);
+}
+
+int main(void) {
+  static const char *texts[] = {
+      "",          "a",          "\r",         "a\r",
+      "\r\n",      "a\r\n",      "a\r\nb",     "\r\r\n",
+      "\n\r",      "a\r\rb\r\n\r\n", "lone\rcr\r\nend\r",
+  };
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "text %zu", i);
+    check_reads(name, texts[i], (uint32_t)strlen(texts[i]));
+    check_mappings(name, texts[i], (uint32_t)strlen(texts[i]));
+  }
+
+  // A CRLF, a lone `\r` and a run of CRLFs at each offset around the end of
+  // the first chunk.
+  for (uint32_t offset = DJOT_CRLF_CHUNK_SIZE - 3;
+       offset <= DJOT_CRLF_CHUNK_SIZE + 2; ++offset) {
+    static const char *tails[] = {"\r\nafter\r\n", "\rafter", "\r\n\r\n\r\n"};
+    for (size_t i = 0; i < sizeof(tails) / sizeof(tails[0]); ++i) {
+      uint32_t tail = (uint32_t)strlen(tails[i]);
+      char *text = malloc(offset + tail);
+      memset(text, 'x', offset);
+      memcpy(text + offset, tails[i], tail);
+      char name[32];
+      snprintf(name, sizeof(name), "tail %zu at %u", i, offset);
+      check_reads(name, text, offset + tail);
+      check_mappings(name, text, offset + tail);
+      free(text);
+    }
+  }
+
+  TSParser *parser = ts_parser_new();
+  if (!ts_parser_set_language(parser, tree_sitter_djot())) {
+    fprintf(stderr, "the parser's ABI version isn't supported by the "
+                    "tree-sitter library\n");
+    return 1;
+  }
+  check_parse_and_edits(parser);
+  ts_parser_delete(parser);
+
+  if (failures) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("CRLF input: all checks passed\n");
+  return 0;
+}
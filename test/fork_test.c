@@ -0,0 +1,114 @@
+// Tests that an unclosed `[`, `![`, `{` or `<` doesn't split the parse
+// stack, see `make test-forks`.
+//
+// Each text is parsed twice: as is, and with the symbol replaced by a
+// letter. The parser logs `process version:N, version_count:M` for each of
+// its versions at every step, and both parses have to split the stack the
+// same number of times. A parse that logs no such line fails, so a runtime
+// with another log format can't pass by counting nothing. Only the symbols that the external scanner lexes as
+// `_unclosed_symbol` are covered. `_`, `*`, `^` and `~`, closed brackets,
+// and brackets whose closer may be further than the scanner looks ahead
+// still split the stack.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tree_sitter/api.h>
+
+const TSLanguage *tree_sitter_djot(void);
+
+static int failures = 0;
+
+typedef struct {
+  unsigned steps;
+  unsigned splits;
+  unsigned version_count;
+} Splits;
+
+static void log_versions(void *payload, TSLogType type, const char *message) {
+  Splits *splits = payload;
+  unsigned version, version_count;
+  if (type != TSLogTypeParse ||
+      sscanf(message, "process version:%u, version_count:%u", &version,
+             &version_count) != 2) {
+    return;
+  }
+  ++splits->steps;
+  if (version != 0) {
+    return;
+  }
+  if (version_count > splits->version_count) {
+    splits->splits += version_count - splits->version_count;
+  }
+  splits->version_count = version_count;
+}
+
+static unsigned count_splits(TSParser *parser, const char *text) {
+  Splits splits = {0, 0, 1};
+  ts_parser_set_logger(parser, (TSLogger){&splits, log_versions});
+  TSTree *tree = ts_parser_parse_string(parser, NULL, text, strlen(text));
+  ts_parser_set_logger(parser, (TSLogger){NULL, NULL});
+  ts_tree_delete(tree);
+  if (splits.steps == 0) {
+    ++failures;
+    fprintf(stderr,
+            "%s:%d: no \"process version:\" lines in the parse log of "
+            "\"%s\"\n",
+            __FILE__, __LINE__, text);
+  }
+  return splits.splits;
+}
+
+// `text` has the symbol at `symbol`, `length` characters long.
+static void check_no_split(TSParser *parser, const char *text, size_t symbol,
+                           size_t length) {
+  char *plain = malloc(strlen(text) + 1);
+  strcpy(plain, text);
+  memset(plain + symbol, 'x', length);
+  unsigned with_symbol = count_splits(parser, text);
+  unsigned without_symbol = count_splits(parser, plain);
+  if (with_symbol != without_symbol) {
+    ++failures;
+    fprintf(stderr, "%s:%d: %u splits for \"%s\", %u without the symbol\n",
+            __FILE__, __LINE__, with_symbol, text, without_symbol);
+  }
+  free(plain);
+}
+
+int main(void) {
+  TSParser *parser = ts_parser_new();
+  if (!ts_parser_set_language(parser, tree_sitter_djot())) {
+    fprintf(stderr, "the parser's ABI version isn't supported by the "
+                    "tree-sitter library\n");
+    return 1;
+  }
+
+  // Texts with a single unclosed symbol, and the symbol.
+  static const char *texts[][2] = {
+      {"a [b c\n", "["},
+      {"a ![b c\n", "!["},
+      {"a [^b c\n", "[^"},
+      {"a {b c\n", "{"},
+      {"a {=b c\n", "{="},
+      {"a <b c\n", "<"},
+      {"a [b c\nd e\n", "["},
+      {"a [b c\n\n]\n", "["},
+      {"a [b _c_ `d`\n", "["},
+      {"- a [b c\n", "["},
+      {"# a [b c\n", "["},
+  };
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    const char *symbol = strstr(texts[i][0], texts[i][1]);
+    check_no_split(parser, texts[i][0], (size_t)(symbol - texts[i][0]),
+                   strlen(texts[i][1]));
+  }
+
+  ts_parser_delete(parser);
+
+  if (failures) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("Unclosed symbols: all checks passed\n");
+  return 0;
+}